@@ -8,16 +8,37 @@
 #ifndef INC_22S_FINAL_PROJ_ARTICLE_H
 #define INC_22S_FINAL_PROJ_ARTICLE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+/// \description Indexed fields of an article. A new field needs an entry here and its tokens in Article
+enum class Field : uint8_t {
+    TEXT,
+    TITLE,
+};
+constexpr size_t FIELD_COUNT = 2;
+
+/// \description Article::published of an article without a (readable) publication date
+constexpr int64_t UNKNOWN_DATE = INT64_MIN;
+
 struct Article {
     std::string id;
     std::string title;
     std::string text;
     std::vector<std::string> persons;
     std::vector<std::string> organizations;
+    /// \description Publication time in seconds since the Unix epoch (UTC), or UNKNOWN_DATE
+    int64_t published = UNKNOWN_DATE;
+    /// \description Lowercase site ("reuters.com") and language ("english"); empty when unknown
+    std::string site;
+    std::string language;
     std::vector<std::string> tokens;
+    /// \description positions[i] -> ascending word offsets of tokens[i] in "text"
+    std::vector<std::vector<uint32_t>> positions;
+    /// \description Distinct index terms of "title"
+    std::vector<std::string> title_tokens;
     friend std::ostream &operator<<(std::ostream &os, const Article &article) { return os << article.id; }
 };
 #endif //INC_22S_FINAL_PROJ_ARTICLE_H
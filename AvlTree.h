@@ -9,8 +9,13 @@
 #define INC_22S_FINAL_PROJ_AVLTREE_H
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <iostream>
 #include <queue>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
 #include "Pair.h"
 #include <string>
 #include <fstream>
@@ -38,12 +43,26 @@ private:
                                       left(lt),
                                       right(rt),
                                       height(h) {}
+
+        AvlNode(K &&key, std::vector<V> &&values) : key(std::move(key)),
+                                                    values(std::move(values)),
+                                                    left(nullptr),
+                                                    right(nullptr),
+                                                    height(0) {}
     };
 
+    //An AVL tree of 2^32 nodes is at most ~46 levels deep, so root-to-leaf paths fit on the stack
+    static constexpr size_t MAX_DEPTH = 64;
+
+    //Every node of this tree lives in "pool"
+    NodePool<AvlNode> pool;
+    size_t node_count = 0;
+
     /// \description    -> Return the node's height.
     int height(AvlNode *&node) { return node != nullptr ? node->height : -1; }
 
-    /// \description    -> Inserts a new node into the AVL tree
+    /// \description    -> Inserts a new node into the AVL tree. Walks down iteratively, remembering the
+    ///                 path, then rebalances back up until a subtree height stops changing
     void insert_node(const K &key, const V &value, AvlNode *&node);
 
     /// \description    -> Search node in the AVL tree
@@ -54,8 +73,15 @@ private:
     void make_empty(AvlNode *&node);
 
     /// \param node     -> A node in the AVL tree
-    /// \description    -> responsible for cloning subtree
-    AvlNode *clone(AvlNode *node) const;
+    /// \description    -> responsible for cloning subtree (keys and values) into this tree's pool
+    AvlNode *clone(AvlNode *node);
+
+    /// \param run      -> Sorted run of (key, values) pairs
+    /// \param first    -> Index of the first pair of the subtree
+    /// \param last     -> One past the index of the last pair of the subtree
+    /// \return node    -> Root of a perfectly balanced subtree over run[first, last)
+    /// \description    -> Median split; recursion depth is log2(n)
+    AvlNode *build_balanced(std::vector<std::pair<K, std::vector<V>>> &run, size_t first, size_t last);
 
     /// \param alpha     -> Node of imbalance
     /// \description    -> Performs "case 1" rotation
@@ -128,10 +154,24 @@ public:
     //constructors
     AvlTree() : root(nullptr) {}
 
-    AvlTree(const AvlTree<K, V> &tree) : root(nullptr) {
+    AvlTree(const AvlTree<K, V> &tree) : total_articles(tree.total_articles),
+                                         total_tokens(tree.total_tokens),
+                                         root(nullptr) {
         root = clone(tree.root);
     }
 
+    /// \param sorted_run   -> (key, values) pairs with strictly ascending keys
+    /// \description        -> Bulk-builds a perfectly balanced tree in O(n). This is how a tree is
+    ///                     rebuilt from an already sorted term list (e.g. after merging two indexes)
+    explicit AvlTree(std::vector<std::pair<K, std::vector<V>>> &&sorted_run) : root(nullptr) {
+        //Equal neighbours would give the tree duplicate keys, which lookups and inserts cannot handle
+        assert(std::adjacent_find(sorted_run.cbegin(), sorted_run.cend(), [](const auto &a, const auto &b) {
+            return !(a.first < b.first);
+        }) == sorted_run.cend());
+        root = build_balanced(sorted_run, 0, sorted_run.size());
+        sorted_run.clear();
+    }
+
     AvlTree(AvlTree<K, V> &&tree) noexcept: root(nullptr) {
         *this = std::move(tree);
     }
@@ -145,9 +185,12 @@ public:
         total_tokens = tree.total_tokens;
 
         if (this != &tree) {
-            this->~AvlTree();
-            this->root = tree.root;
+            make_empty(root);
+            pool = std::move(tree.pool);
+            root = tree.root;
+            node_count = tree.node_count;
             tree.root = nullptr;
+            tree.node_count = 0;
         }
         return *this;
     }
@@ -190,6 +233,12 @@ public:
     /// \desciption             -> Implement Pre Order traversal method, and populate priority queue for each visit
     void pre_order(AvlNode *node, std::priority_queue<Pair>& queue);
 
+    /// \param visit            -> Callable taking (const K &key, const std::vector<V> &values)
+    /// \return None            -> N/A
+    /// \description            -> Visits every node in ascending key order, without recursion
+    template<typename F>
+    void in_order(F &&visit) const;
+
     /// \param None             -> N/A
     /// \return None            ->
     /// \description            -> Prints a list of the most 25 frequent words in the AVL tree to the console
@@ -205,62 +254,108 @@ public:
     /// \description            -> clears persistent file content
     void clear_persistent_file();
 
-    size_t size() {
-        return size(root);
-    }
-    size_t size(AvlNode *node) {
-        if (node == nullptr) {
-            return 0;
-        }
-        return size(node->left) + size(node->right) + 1;
-    }
+    /// \return size_t      -> Number of distinct keys in the tree, maintained on insert
+    size_t size() const { return node_count; }
 };
 
 template<typename K, typename V>
 void AvlTree<K, V>::make_empty(AvlTree::AvlNode *&node) {
-    if (node != nullptr) {
-        make_empty(node->left);
-        make_empty(node->right);
-        delete node;
+    //Post-order is not needed: children are pushed before their parent is destroyed
+    std::vector<AvlNode *> stack;
+    if (node != nullptr) stack.push_back(node);
+    while (!stack.empty()) {
+        AvlNode *current = stack.back();
+        stack.pop_back();
+        if (current->left != nullptr) stack.push_back(current->left);
+        if (current->right != nullptr) stack.push_back(current->right);
+        pool.destroy(current);
+        --node_count;
     }
     node = nullptr;
+    if (node_count == 0) {
+        pool.release();
+    }
+}
+
+template<typename K, typename V>
+typename AvlTree<K, V>::AvlNode *AvlTree<K, V>::clone(AvlNode *node) {
+    AvlNode *copy_root = nullptr;
+    //Each entry is a source node and the link in the copy it must be attached to
+    std::vector<std::pair<AvlNode *, AvlNode **>> stack;
+    if (node != nullptr) stack.emplace_back(node, &copy_root);
+    while (!stack.empty()) {
+        auto [source, link] = stack.back();
+        stack.pop_back();
+        AvlNode *copy = pool.create(source->key, nullptr, nullptr, source->height);
+        copy->values = source->values;
+        *link = copy;
+        ++node_count;
+        if (source->left != nullptr) stack.emplace_back(source->left, &copy->left);
+        if (source->right != nullptr) stack.emplace_back(source->right, &copy->right);
+    }
+    return copy_root;
 }
 
 template<typename K, typename V>
-typename AvlTree<K, V>::AvlNode *AvlTree<K, V>::clone(AvlNode *node) const {
-    if (node == nullptr)
+typename AvlTree<K, V>::AvlNode *
+AvlTree<K, V>::build_balanced(std::vector<std::pair<K, std::vector<V>>> &run, size_t first, size_t last) {
+    if (first >= last) {
         return nullptr;
-    else {
-        return new AvlNode{node->key, clone(node->left), clone(node->right), node->height};
     }
+    size_t middle = first + (last - first) / 2;
+    AvlNode *node = pool.create(std::move(run[middle].first), std::move(run[middle].second));
+    ++node_count;
+    node->left = build_balanced(run, first, middle);
+    node->right = build_balanced(run, middle + 1, last);
+    node->height = std::max(height(node->left), height(node->right)) + 1;
+    return node;
 }
 
 //insert_node implementation
 template<typename K, typename V>
 void AvlTree<K, V>::insert_node(const K &key, const V &value, AvlNode *&node) {
-    if (node == nullptr) {
-        node = new AvlNode(key);
-        node->values.emplace_back(value);
-    } else if (key < node->key) {
-        insert_node(key, value, node->left);
-    } else if (node->key < key) {
-        insert_node(key, value, node->right);
-    } else {
-        node->values.emplace_back(value);
+    std::array<AvlNode **, MAX_DEPTH> path;
+    size_t depth = 0;
+    AvlNode **link = &node;
+    while (*link != nullptr) {
+        path[depth++] = link;
+        if (key < (*link)->key) {
+            link = &(*link)->left;
+        } else if ((*link)->key < key) {
+            link = &(*link)->right;
+        } else {
+            //Existing key: the shape of the tree does not change
+            (*link)->values.emplace_back(value);
+            return;
+        }
+    }
+    *link = pool.create(key);
+    (*link)->values.emplace_back(value);
+    ++node_count;
+
+    //Walk back up; once a subtree keeps its height, nothing above it can be out of balance
+    while (depth > 0) {
+        AvlNode *&ancestor = *path[--depth];
+        int old_height = ancestor->height;
+        balance(ancestor);
+        if (ancestor->height == old_height) {
+            break;
+        }
     }
-    balance(node);
 }
 
 template<typename K, typename V>
 std::vector<V> *AvlTree<K, V>::search_node(const K &key, AvlTree::AvlNode *node) const {
-    if (node == nullptr) return nullptr;
-    if (node->key < key) {
-        return search_node(key, node->right);
-    } else if (key < node->key) {
-        return search_node(key, node->left);
-    } else {
-        return &node->values;
+    while (node != nullptr) {
+        if (node->key < key) {
+            node = node->right;
+        } else if (key < node->key) {
+            node = node->left;
+        } else {
+            return &node->values;
+        }
     }
+    return nullptr;
 }
 
 template<typename K, typename V>
@@ -280,14 +375,12 @@ void AvlTree<K, V>::balance(AvlTree::AvlNode *&node) {
     }
         // Is the height of the right subtree greater than the left subtree?
     else if (height(node->right) - height(node->left) > 1) {
+        // Check if RR is the node of imbalance
         if (height(node->right->right) >= height(node->right->left)) {
-            // Check if RR is the node of imbalance
-            if (height(node->right->right) >= height(node->right->left)) {
-                rotate_with_right_child(node);
-            } // Else the RL node is the node of imbalance
-            else {
-                double_with_right_child(node);
-            }
+            rotate_with_right_child(node);
+        } // Else the RL node is the node of imbalance
+        else {
+            double_with_right_child(node);
         }
     }
     node->height = std::max(height(node->left), height(node->right)) + 1;
@@ -329,14 +422,35 @@ void AvlTree<K, V>::rotate_with_right_child(AvlTree::AvlNode *&alpha) {
 template<typename K, typename V>
 void AvlTree<K, V>::pre_order(AvlNode *node, std::priority_queue<Pair>& queue){
     //1- Visit all nodes in AVL tree starting from root (PreOrder Traversal)
-    if(node != nullptr){
+    std::vector<AvlNode *> stack;
+    if (node != nullptr) stack.push_back(node);
+    while (!stack.empty()) {
+        AvlNode *current = stack.back();
+        stack.pop_back();
         //2- For each (Make a "pair" object) && (Add to "queue")
-        Pair p(node->key, node->values.size());
+        Pair p(current->key, current->values.size());
         queue.push(p);
 
         //continue visiting and adding to "queue"
-        pre_order(node->left, queue);
-        pre_order(node->right, queue);
+        if (current->right != nullptr) stack.push_back(current->right);
+        if (current->left != nullptr) stack.push_back(current->left);
+    }
+}
+
+template<typename K, typename V>
+template<typename F>
+void AvlTree<K, V>::in_order(F &&visit) const {
+    std::array<const AvlNode *, MAX_DEPTH> stack;
+    size_t depth = 0;
+    const AvlNode *node = root;
+    while (node != nullptr || depth > 0) {
+        while (node != nullptr) {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        node = stack[--depth];
+        visit(node->key, node->values);
+        node = node->right;
     }
 }
 
@@ -346,7 +460,7 @@ void AvlTree<K, V>::proposition_279() {
     pre_order(root, p_queue);
     //3- 25x (Print priority queue top, then pop)
 
-    for(int i = 0; i < 25; i++){
+    for(int i = 0; i < 25 && !p_queue.empty(); i++){
         std::cout << p_queue.top().word << " -> " << p_queue.top().articles << '\n';
         p_queue.pop();
     }
@@ -0,0 +1,90 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Bitmap.h
+ * @date:           10-19-2026
+ * @description:    Fixed-size bitset over document ordinals, with a running count of set bits
+ */
+
+#ifndef INC_22S_FINAL_PROJ_BITMAP_H
+#define INC_22S_FINAL_PROJ_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Bitmap {
+private:
+    std::vector<uint64_t> words;
+    size_t bits = 0;
+    size_t set_bits = 0;
+
+public:
+    Bitmap() = default;
+
+    /// \param size         -> Number of bits, all cleared
+    explicit Bitmap(size_t size) : words((size + 63) / 64, 0), bits(size) {}
+
+    /// \return bool        -> Whether bit "i" is set
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    /// \return bool        -> Whether bit "i" was clear before
+    bool set(size_t i) {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        if (words[i >> 6] & mask) return false;
+        words[i >> 6] |= mask;
+        ++set_bits;
+        return true;
+    }
+
+    /// \param w            -> Word to update: bits 64 * w to 64 * w + 63
+    /// \param mask         -> Bits of the word to set, lowest bit first
+    void set_word(size_t w, uint64_t mask) {
+        mask &= ~words[w];
+        words[w] |= mask;
+        set_bits += static_cast<size_t>(__builtin_popcountll(mask));
+    }
+
+    /// \return size_t      -> Number of bits
+    size_t size() const { return bits; }
+
+    /// \return size_t      -> Number of set bits
+    size_t count() const { return set_bits; }
+
+    /// \param excluded     -> Bitmap of the same size, or nullptr
+    /// \return size_t      -> Number of bits set here and not in "excluded"
+    size_t count_and_not(const Bitmap *excluded) const {
+        if (excluded == nullptr) return set_bits;
+        size_t total = 0;
+        for (size_t w = 0; w < words.size(); ++w) {
+            total += static_cast<size_t>(__builtin_popcountll(words[w] & ~excluded->words[w]));
+        }
+        return total;
+    }
+
+    /// \return size_t      -> Memory held by the bits
+    size_t bytes() const { return words.size() * sizeof(uint64_t); }
+
+    /// \return size_t      -> Index of the first set bit >= from, or size() if there is none
+    size_t next(size_t from) const {
+        if (from >= bits) return bits;
+        size_t w = from >> 6;
+        uint64_t word = words[w] & (~uint64_t(0) << (from & 63));
+        while (word == 0) {
+            if (++w == words.size()) return bits;
+            word = words[w];
+        }
+        return w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+    }
+
+    /// \param f            -> Called with the index of every set bit, ascending
+    template<typename F>
+    void for_each(F &&f) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                f(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+            }
+        }
+    }
+};
+
+#endif //INC_22S_FINAL_PROJ_BITMAP_H
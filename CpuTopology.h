@@ -0,0 +1,181 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       CpuTopology.h
+ * @date:           10-19-2026
+ * @description:    Discovers which CPUs belong to which NUMA node (from /sys on Linux) and turns
+ *                  CPU lists into ThreadPoolConfig objects: explicit thread counts, per-core or
+ *                  per-node pinning, and disjoint CPU sets for pools sharing one machine
+ */
+
+#ifndef INC_22S_FINAL_PROJ_CPUTOPOLOGY_H
+#define INC_22S_FINAL_PROJ_CPUTOPOLOGY_H
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "thread_pool.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+enum class Pinning {
+    NONE,   // let the OS schedule workers anywhere in the CPU list
+    CORE,   // worker i runs on exactly one CPU of the list
+    NODE,   // workers may float across the CPUs of their NUMA node
+};
+
+class CpuTopology {
+private:
+    //CPUs of every NUMA node, in node order
+    std::vector<std::vector<int>> nodes;
+
+public:
+    /// \return CpuTopology     -> Topology of this machine, restricted to the CPUs this process may run on.
+    ///                         Machines without NUMA information are reported as a single node
+    static CpuTopology detect() {
+        CpuTopology topology;
+        std::vector<int> allowed = allowed_cpus();
+#ifdef __linux__
+        for (int node = 0;; ++node) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!cpulist) break;
+            std::string line;
+            std::getline(cpulist, line);
+            std::vector<int> cpus;
+            for (int cpu: parse_cpu_list(line)) {
+                if (std::find(allowed.cbegin(), allowed.cend(), cpu) != allowed.cend()) cpus.push_back(cpu);
+            }
+            if (!cpus.empty()) topology.nodes.push_back(std::move(cpus));
+        }
+#endif
+        if (topology.nodes.empty()) {
+            topology.nodes.push_back(std::move(allowed));
+        }
+        return topology;
+    }
+
+    /// \param list         -> Linux CPU list such as "0-3,8,10-11"
+    /// \return vector<int> -> The CPUs in the list, ascending
+    static std::vector<int> parse_cpu_list(const std::string &list) {
+        std::vector<int> cpus;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty() || range == "\n") continue;
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            if (last < first) throw std::invalid_argument("bad CPU range: " + range);
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    /// \return vector<int> -> CPUs the process is allowed to run on
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+                cpus.push_back(static_cast<int>(cpu));
+            }
+        }
+        return cpus;
+    }
+
+    size_t node_count() const { return nodes.size(); }
+
+    /// \return vector<int> -> Every CPU, grouped by NUMA node
+    std::vector<int> all_cpus() const {
+        std::vector<int> cpus;
+        for (const std::vector<int> &node: nodes) cpus.insert(cpus.end(), node.cbegin(), node.cend());
+        return cpus;
+    }
+
+    /// \return int         -> NUMA node owning "cpu", 0 if unknown
+    int node_of(int cpu) const {
+        for (size_t node = 0; node < nodes.size(); ++node) {
+            if (std::find(nodes[node].cbegin(), nodes[node].cend(), cpu) != nodes[node].cend()) {
+                return static_cast<int>(node);
+            }
+        }
+        return 0;
+    }
+
+    /// \param cpus         -> CPU list to divide
+    /// \param first_count  -> Number of CPUs for the first set
+    /// \return pair        -> Two disjoint CPU sets. CPUs are taken in node order, so the first set fills
+    ///                     whole nodes before spilling onto the next one (e.g. ingest pool vs query pool)
+    std::pair<std::vector<int>, std::vector<int>> split(const std::vector<int> &cpus, size_t first_count) const {
+        std::vector<int> ordered;
+        for (int cpu: all_cpus()) {
+            if (std::find(cpus.cbegin(), cpus.cend(), cpu) != cpus.cend()) ordered.push_back(cpu);
+        }
+        first_count = std::min(first_count, ordered.size());
+        return {std::vector<int>(ordered.cbegin(), ordered.cbegin() + static_cast<long>(first_count)),
+                std::vector<int>(ordered.cbegin() + static_cast<long>(first_count), ordered.cend())};
+    }
+
+    /// \param cpus         -> CPUs the pool may use (empty means every allowed CPU)
+    /// \param threads      -> Number of workers, 0 means one per CPU in "cpus"
+    /// \param pinning      -> How tightly workers are bound to "cpus"
+    /// \return config      -> Configuration for ThreadPool. Workers are grouped by NUMA node so they
+    ///                     steal from node-local workers first
+    ThreadPoolConfig pool_config(std::vector<int> cpus, size_t threads, Pinning pinning) const {
+        if (cpus.empty()) cpus = all_cpus();
+        if (threads == 0) threads = cpus.size();
+
+        //Keep node order so consecutive workers share a node
+        std::vector<int> ordered;
+        for (int cpu: all_cpus()) {
+            if (std::find(cpus.cbegin(), cpus.cend(), cpu) != cpus.cend()) ordered.push_back(cpu);
+        }
+        if (ordered.empty()) throw std::invalid_argument("none of the requested CPUs are available");
+
+        ThreadPoolConfig config;
+        config.threads = threads;
+        for (size_t worker = 0; worker < threads; ++worker) {
+            int cpu = ordered[worker % ordered.size()];
+            int node = node_of(cpu);
+            config.worker_nodes.push_back(node);
+            switch (pinning) {
+                case Pinning::NONE:
+                    config.worker_cpus.push_back(ordered);
+                    break;
+                case Pinning::CORE:
+                    config.worker_cpus.push_back({cpu});
+                    break;
+                case Pinning::NODE: {
+                    std::vector<int> node_cpus;
+                    for (int candidate: nodes[static_cast<size_t>(node)]) {
+                        if (std::find(ordered.cbegin(), ordered.cend(), candidate) != ordered.cend()) {
+                            node_cpus.push_back(candidate);
+                        }
+                    }
+                    config.worker_cpus.push_back(std::move(node_cpus));
+                    break;
+                }
+            }
+        }
+        return config;
+    }
+};
+
+#endif //INC_22S_FINAL_PROJ_CPUTOPOLOGY_H
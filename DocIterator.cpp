@@ -0,0 +1,217 @@
+#include "DocIterator.h"
+
+#include <algorithm>
+
+uint32_t ListIterator::step() {
+    return next_index < list.size() ? list[next_index++] : END;
+}
+
+uint32_t ListIterator::seek(uint32_t target) {
+    if (!gallop) {
+        while (next_index < list.size() && list[next_index] < target) {
+            ++next_index;
+        }
+        return next_index < list.size() ? list[next_index++] : END;
+    }
+    //Gallop: double the stride until it overshoots "target", then binary search the last stride
+    size_t low = next_index;
+    size_t gap = 1;
+    while (low + gap < list.size() && list[low + gap] < target) {
+        low += gap;
+        gap <<= 1;
+    }
+    auto high = list.cbegin() + static_cast<long>(std::min(low + gap + 1, list.size()));
+    auto found = std::lower_bound(list.cbegin() + static_cast<long>(low), high, target);
+    if (found == list.cend()) {
+        next_index = list.size();
+        return END;
+    }
+    next_index = static_cast<size_t>(found - list.cbegin()) + 1;
+    return *found;
+}
+
+std::unique_ptr<DocIterator> ListIterator::empty() {
+    static const std::vector<uint32_t> none;
+    return std::make_unique<ListIterator>(none);
+}
+
+uint32_t DeltaIterator::step() {
+    if (data == end) {
+        return END;
+    }
+    previous += static_cast<uint32_t>(Positions::get_varint(data));
+    return previous;
+}
+
+uint32_t DeltaIterator::seek(uint32_t target) {
+    uint32_t doc;
+    do {
+        doc = step();
+    } while (doc != END && doc < target);
+    return doc;
+}
+
+uint32_t UnionIterator::smallest() const {
+    uint32_t doc = END;
+    for (const auto &child: children) {
+        doc = std::min(doc, child->doc());
+    }
+    return doc;
+}
+
+uint32_t UnionIterator::step() {
+    //Children sitting on the current ordinal move on; the others are already past it
+    for (auto &child: children) {
+        if (!child->started() || child->doc() == doc()) {
+            child->next();
+        }
+    }
+    return smallest();
+}
+
+uint32_t UnionIterator::seek(uint32_t target) {
+    for (auto &child: children) {
+        child->advance_to(target);
+    }
+    return smallest();
+}
+
+size_t UnionIterator::cost() const {
+    size_t total = 0;
+    for (const auto &child: children) {
+        total += child->cost();
+    }
+    return total;
+}
+
+ConjunctionIterator::ConjunctionIterator(std::vector<std::unique_ptr<DocIterator>> &&children)
+        : children(std::move(children)) {
+    std::stable_sort(this->children.begin(), this->children.end(),
+                     [](const auto &a, const auto &b) { return a->cost() < b->cost(); });
+}
+
+uint32_t ConjunctionIterator::align(uint32_t candidate) {
+    while (candidate != END) {
+        uint32_t agreed = candidate;
+        for (size_t i = 1; i < children.size() && agreed == candidate; ++i) {
+            agreed = children[i]->advance_to(candidate);
+        }
+        if (agreed == candidate) {
+            return candidate;
+        }
+        //Some child skipped past the candidate: the lead jumps there
+        candidate = children.front()->advance_to(agreed);
+    }
+    return END;
+}
+
+uint32_t ConjunctionIterator::step() {
+    return align(children.front()->next());
+}
+
+uint32_t ConjunctionIterator::seek(uint32_t target) {
+    return align(children.front()->advance_to(target));
+}
+
+uint32_t ExclusionIterator::skip_excluded(uint32_t candidate) {
+    while (candidate != END && exclude->advance_to(candidate) == candidate) {
+        candidate = include->next();
+    }
+    return candidate;
+}
+
+uint32_t ExclusionIterator::step() {
+    return skip_excluded(include->next());
+}
+
+uint32_t ExclusionIterator::seek(uint32_t target) {
+    return skip_excluded(include->advance_to(target));
+}
+
+/// \param positions    -> Positions of each phrase term in one document
+/// \param offsets      -> Offset of each term in the phrase
+/// \param slop         -> Extra words allowed
+/// \return bool        -> Whether the terms occur in phrase order within the allowed distance
+static bool positions_match(const std::vector<std::vector<uint32_t>> &positions,
+                            const std::vector<uint32_t> &offsets, uint32_t slop) {
+    uint32_t span = offsets.back() - offsets.front();
+    for (uint32_t first: positions.front()) {
+        if (slop == 0) {
+            //Exact: every term sits exactly at its offset from the first one
+            bool all = true;
+            for (size_t t = 1; t < positions.size() && all; ++t) {
+                all = std::binary_search(positions[t].cbegin(), positions[t].cend(),
+                                         first + offsets[t] - offsets.front());
+            }
+            if (all) return true;
+            continue;
+        }
+        //Proximity: take the earliest occurrence of each term after the previous one
+        uint32_t previous = first;
+        for (size_t t = 1; t < positions.size(); ++t) {
+            auto next = std::upper_bound(positions[t].cbegin(), positions[t].cend(), previous);
+            if (next == positions[t].cend()) return false;
+            previous = *next;
+        }
+        if (previous - first <= span + slop) return true;
+    }
+    return false;
+}
+
+PhraseIterator::PhraseIterator(const std::vector<const std::vector<uint32_t> *> &postings,
+                               const std::vector<const std::vector<uint8_t> *> &blobs,
+                               const std::vector<uint32_t> &offsets, uint32_t slop)
+        : offsets(offsets), slop(slop), positions(postings.size()) {
+    std::vector<std::unique_ptr<DocIterator>> lists;
+    for (size_t t = 0; t < postings.size(); ++t) {
+        lists.push_back(std::make_unique<ListIterator>(*postings[t]));
+        terms.push_back({postings[t], Positions::Reader(*blobs[t]), 0});
+    }
+    documents = std::make_unique<ConjunctionIterator>(std::move(lists));
+}
+
+bool PhraseIterator::verify(uint32_t doc) {
+    //Each term walks its postings and positions blob in step, skipping the entries of documents passed over
+    for (size_t t = 0; t < terms.size(); ++t) {
+        Term &term = terms[t];
+        while ((*term.postings)[term.cursor] < doc) {
+            term.reader.skip();
+            ++term.cursor;
+        }
+        term.reader.read(positions[t]);
+        ++term.cursor;
+    }
+    return positions_match(positions, offsets, slop);
+}
+
+uint32_t PhraseIterator::skip_unverified(uint32_t candidate) {
+    while (candidate != END && !verify(candidate)) {
+        candidate = documents->next();
+    }
+    return candidate;
+}
+
+uint32_t PhraseIterator::step() {
+    return skip_unverified(documents->next());
+}
+
+uint32_t PhraseIterator::seek(uint32_t target) {
+    return skip_unverified(documents->advance_to(target));
+}
+
+uint32_t ProfiledIterator::record(uint32_t doc, std::chrono::high_resolution_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    seconds += elapsed.count();
+    produced += doc != END;
+    return doc;
+}
+
+uint32_t ProfiledIterator::step() {
+    auto start = std::chrono::high_resolution_clock::now();
+    return record(inner->next(), start);
+}
+
+uint32_t ProfiledIterator::seek(uint32_t target) {
+    auto start = std::chrono::high_resolution_clock::now();
+    return record(inner->advance_to(target), start);
+}
@@ -0,0 +1,258 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       DocIterator.h
+ * @date:           10-19-2026
+ * @description:    Lazy, doc-at-a-time iterators over the local ordinals of one segment. A compiled query is
+ *                  a tree of them: leaves walk postings lists (or compressed entity sets), inner nodes
+ *                  combine their children without materializing anything.
+ *                      - next() moves to the next matching ordinal
+ *                      - advance_to(target) moves to the first matching ordinal >= target, skipping ahead
+ *                        (postings lists gallop) instead of stepping through everything in between
+ *                      - cost() is an upper bound on the number of matches, used to order children so
+ *                        that a conjunction is driven by its rarest clause
+ *                  Both return END once the iterator is exhausted. Iterators never move backwards.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_DOCITERATOR_H
+#define INC_22S_FINAL_PROJ_DOCITERATOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Bitmap.h"
+#include "Positions.h"
+
+class DocIterator {
+private:
+    bool positioned = false;
+    uint32_t current = 0;
+
+protected:
+    /// \return uint32_t    -> The ordinal after the current one (the first one on the first call), or END
+    virtual uint32_t step() = 0;
+
+    /// \param target       -> Ordinal greater than the current one
+    /// \return uint32_t    -> The first matching ordinal >= target, or END
+    virtual uint32_t seek(uint32_t target) = 0;
+
+public:
+    static constexpr uint32_t END = UINT32_MAX;
+
+    virtual ~DocIterator() = default;
+
+    /// \return uint32_t    -> The current ordinal (END once exhausted). Only valid after next() or advance_to()
+    uint32_t doc() const { return current; }
+
+    /// \return bool        -> Whether next() or advance_to() was called
+    bool started() const { return positioned; }
+
+    uint32_t next() {
+        positioned = true;
+        return current = current == END ? END : step();
+    }
+
+    uint32_t advance_to(uint32_t target) {
+        if (positioned && current >= target) {
+            return current;
+        }
+        positioned = true;
+        return current = target == END ? END : seek(target);
+    }
+
+    /// \return size_t      -> Upper bound on the number of ordinals this iterator yields
+    virtual size_t cost() const = 0;
+};
+
+/// \description Walks an ascending postings list owned by the segment
+class ListIterator : public DocIterator {
+private:
+    const std::vector<uint32_t> &list;
+    size_t next_index = 0;
+    bool gallop;
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    /// \param list         -> Postings to walk
+    /// \param gallop       -> How advance_to skips ahead: galloping then binary search, for targets that are
+    ///                     usually far apart, or a linear merge, for targets about as dense as the list
+    explicit ListIterator(const std::vector<uint32_t> &list, bool gallop = true) : list(list), gallop(gallop) {}
+
+    /// \return ListIterator -> An iterator that matches nothing
+    static std::unique_ptr<DocIterator> empty();
+
+    size_t cost() const override { return list.size(); }
+};
+
+/// \description Decodes a varint-delta ordinal set (EntityIndex) as it goes
+class DeltaIterator : public DocIterator {
+private:
+    const uint8_t *data;
+    const uint8_t *end;
+    uint32_t previous = 0;
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    explicit DeltaIterator(const std::vector<uint8_t> &blob) : data(blob.data()), end(blob.data() + blob.size()) {}
+
+    /// \description        -> Every ordinal takes at least one byte
+    size_t cost() const override { return static_cast<size_t>(end - data); }
+};
+
+/// \description Walks the set bits of a bitmap over the segment's ordinals
+class BitmapIterator : public DocIterator {
+private:
+    const Bitmap &bitmap;
+    size_t next_bit = 0;
+
+protected:
+    uint32_t step() override { return seek(static_cast<uint32_t>(next_bit)); }
+
+    uint32_t seek(uint32_t target) override {
+        size_t found = bitmap.next(std::max<size_t>(target, next_bit));
+        next_bit = found + 1;
+        return found == bitmap.size() ? END : static_cast<uint32_t>(found);
+    }
+
+public:
+    explicit BitmapIterator(const Bitmap &bitmap) : bitmap(bitmap) {}
+
+    size_t cost() const override { return bitmap.count(); }
+};
+
+/// \description Ordinals matched by any child (OR)
+class UnionIterator : public DocIterator {
+private:
+    std::vector<std::unique_ptr<DocIterator>> children;
+
+    /// \return uint32_t    -> Smallest current ordinal of the children
+    uint32_t smallest() const;
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    explicit UnionIterator(std::vector<std::unique_ptr<DocIterator>> &&children) : children(std::move(children)) {}
+
+    size_t cost() const override;
+};
+
+/// \description Ordinals matched by every child (AND). Children are ordered by cost: the cheapest one leads
+///              and the others are only asked to advance_to its candidates
+class ConjunctionIterator : public DocIterator {
+private:
+    std::vector<std::unique_ptr<DocIterator>> children;
+
+    /// \param candidate    -> Ordinal the lead is on
+    /// \return uint32_t    -> The first ordinal >= candidate all children agree on, or END
+    uint32_t align(uint32_t candidate);
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    explicit ConjunctionIterator(std::vector<std::unique_ptr<DocIterator>> &&children);
+
+    size_t cost() const override { return children.front()->cost(); }
+};
+
+/// \description Ordinals of "include" that "exclude" does not match (AND NOT)
+class ExclusionIterator : public DocIterator {
+private:
+    std::unique_ptr<DocIterator> include;
+    std::unique_ptr<DocIterator> exclude;
+
+    /// \return uint32_t    -> The first ordinal >= candidate of "include" that is not excluded, or END
+    uint32_t skip_excluded(uint32_t candidate);
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    ExclusionIterator(std::unique_ptr<DocIterator> include, std::unique_ptr<DocIterator> exclude)
+            : include(std::move(include)), exclude(std::move(exclude)) {}
+
+    size_t cost() const override { return include->cost(); }
+};
+
+/// \description Documents containing the phrase terms in order, within the allowed slop. The terms' postings
+///              are intersected first; only the documents they agree on have their positions decoded
+class PhraseIterator : public DocIterator {
+private:
+    struct Term {
+        const std::vector<uint32_t> *postings;
+        Positions::Reader reader;
+        size_t cursor;
+    };
+    std::unique_ptr<DocIterator> documents;
+    std::vector<Term> terms;
+    std::vector<uint32_t> offsets;
+    uint32_t slop;
+    std::vector<std::vector<uint32_t>> positions;
+
+    /// \return bool        -> Whether the terms line up in document "doc"
+    bool verify(uint32_t doc);
+
+    /// \return uint32_t    -> The first ordinal >= candidate that contains the phrase, or END
+    uint32_t skip_unverified(uint32_t candidate);
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    /// \param postings     -> Text postings of each phrase term, in phrase order
+    /// \param blobs        -> Positions blob of each term, aligned with its postings
+    /// \param offsets      -> Word offset of each term in the phrase
+    /// \param slop         -> Extra words allowed between the terms
+    PhraseIterator(const std::vector<const std::vector<uint32_t> *> &postings,
+                   const std::vector<const std::vector<uint8_t> *> &blobs,
+                   const std::vector<uint32_t> &offsets, uint32_t slop);
+
+    size_t cost() const override { return documents->cost(); }
+};
+
+/// \description Counts the ordinals another iterator produces and the time spent in it, children included
+///              (EXPLAIN)
+class ProfiledIterator : public DocIterator {
+private:
+    std::unique_ptr<DocIterator> inner;
+    size_t &produced;
+    double &seconds;
+
+    /// \return uint32_t    -> "doc", after counting it and the time elapsed since "start"
+    uint32_t record(uint32_t doc, std::chrono::high_resolution_clock::time_point start);
+
+protected:
+    uint32_t step() override;
+
+    uint32_t seek(uint32_t target) override;
+
+public:
+    /// \param inner        -> Iterator to measure
+    /// \param produced     -> Incremented for every ordinal it yields
+    /// \param seconds      -> Incremented by the time spent in it
+    ProfiledIterator(std::unique_ptr<DocIterator> inner, size_t &produced, double &seconds)
+            : inner(std::move(inner)), produced(produced), seconds(seconds) {}
+
+    size_t cost() const override { return inner->cost(); }
+};
+
+#endif //INC_22S_FINAL_PROJ_DOCITERATOR_H
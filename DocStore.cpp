@@ -0,0 +1,229 @@
+#include "DocStore.h"
+#include "Lz.h"
+#include "Positions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+/// \return path        -> A store file no other process uses, in the system's temporary directory
+static std::filesystem::path temporary_path() {
+    std::random_device random;
+    uint64_t name = static_cast<uint64_t>(random()) << 32 | random();
+    return std::filesystem::temp_directory_path() / ("googleyes-store-" + std::to_string(name) + ".dat");
+}
+
+static void put_string(std::vector<uint8_t> &out, const std::string &value) {
+    Positions::put_varint(out, value.size());
+    out.insert(out.end(), value.cbegin(), value.cend());
+}
+
+static void get_string(const uint8_t *&data, std::string &value) {
+    size_t length = Positions::get_varint(data);
+    value.assign(reinterpret_cast<const char *>(data), length);
+    data += length;
+}
+
+/// \return uint8_t*    -> First byte after the record starting at "record"
+static const uint8_t *skip_record(const uint8_t *record) {
+    //uuid, title and text, then the persons and the organizations, then the publication time, site and language
+    for (int field = 0; field < 3; ++field) {
+        size_t length = Positions::get_varint(record);
+        record += length;
+    }
+    for (int kind = 0; kind < 2; ++kind) {
+        for (size_t names = Positions::get_varint(record); names > 0; --names) {
+            size_t length = Positions::get_varint(record);
+            record += length;
+        }
+    }
+    record += sizeof(int64_t);
+    for (int field = 0; field < 2; ++field) {
+        size_t length = Positions::get_varint(record);
+        record += length;
+    }
+    return record;
+}
+
+DocStore::DocStore(std::filesystem::path path, size_t block_bytes, size_t cache_blocks)
+        : path(path.empty() ? temporary_path() : path), temporary(path.empty()),
+          block_bytes(block_bytes), cache_blocks(std::max<size_t>(cache_blocks, 1)) {
+    file.open(this->path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot create " + this->path.string());
+    }
+    reader = ::open(this->path.c_str(), O_RDONLY);
+    if (reader < 0) {
+        throw std::runtime_error("Cannot open " + this->path.string());
+    }
+}
+
+DocStore::~DocStore() {
+    ::close(reader);
+    file.close();
+    if (temporary) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+}
+
+void DocStore::append(DocId id, const Article &article) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id != open_first + open_records.size()) {
+        throw std::logic_error("DocStore::append out of DocId order");
+    }
+    size_t start = open_data.size();
+    open_records.push_back(static_cast<uint32_t>(start));
+    put_string(open_data, article.id);
+    put_string(open_data, article.title);
+    put_string(open_data, article.text);
+    Positions::put_varint(open_data, article.persons.size());
+    for (const std::string &person: article.persons) put_string(open_data, person);
+    Positions::put_varint(open_data, article.organizations.size());
+    for (const std::string &organization: article.organizations) put_string(open_data, organization);
+    const auto *published = reinterpret_cast<const uint8_t *>(&article.published);
+    open_data.insert(open_data.end(), published, published + sizeof(article.published));
+    put_string(open_data, article.site);
+    put_string(open_data, article.language);
+    raw_bytes += open_data.size() - start;
+    if (open_data.size() >= block_bytes) {
+        seal();
+    }
+}
+
+void DocStore::seal() {
+    std::vector<uint8_t> compressed;
+    Lz::compress(open_data.data(), open_data.size(), compressed);
+    file.seekp(static_cast<std::streamoff>(file_size));
+    file.write(reinterpret_cast<const char *>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Failed writing " + path.string());
+    }
+    blocks.push_back({open_first, file_size, static_cast<uint32_t>(compressed.size()),
+                      static_cast<uint32_t>(open_data.size())});
+    file_size += compressed.size();
+    open_first += static_cast<DocId>(open_records.size());
+    open_data.clear();
+    open_records.clear();
+}
+
+std::shared_ptr<const DocStore::CachedBlock> DocStore::load(size_t number, const Block &block, DocId end) const {
+    //1- Read the compressed block; pread keeps no position, so concurrent misses do not disturb each other
+    std::vector<uint8_t> compressed(block.compressed_size);
+    size_t done = 0;
+    while (done < compressed.size()) {
+        ssize_t got = ::pread(reader, compressed.data() + done, compressed.size() - done,
+                              static_cast<off_t>(block.offset + done));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            throw std::runtime_error("Failed reading " + path.string());
+        }
+        done += static_cast<size_t>(got);
+    }
+
+    //2- Decompress it and find its records, which are back to back
+    auto entry = std::make_shared<CachedBlock>();
+    entry->number = number;
+    entry->first = block.first;
+    Lz::decompress(compressed.data(), compressed.size(), block.raw_size, entry->data);
+    const uint8_t *data = entry->data.data();
+    entry->records.reserve(end - block.first);
+    for (DocId id = block.first; id < end; ++id) {
+        entry->records.push_back(static_cast<uint32_t>(data - entry->data.data()));
+        data = skip_record(data);
+    }
+    return entry;
+}
+
+void DocStore::decode(const uint8_t *record, Article &article) {
+    get_string(record, article.id);
+    get_string(record, article.title);
+    get_string(record, article.text);
+    article.persons.resize(Positions::get_varint(record));
+    for (std::string &person: article.persons) get_string(record, person);
+    article.organizations.resize(Positions::get_varint(record));
+    for (std::string &organization: article.organizations) get_string(record, organization);
+    std::memcpy(&article.published, record, sizeof(article.published));
+    record += sizeof(article.published);
+    get_string(record, article.site);
+    get_string(record, article.language);
+}
+
+Article DocStore::fetch(DocId id) const {
+    Article article;
+    std::shared_ptr<const CachedBlock> found;
+    size_t number;
+    Block block{};
+    DocId end;
+    {
+        //1- Under the mutex: decode from the open block, or find the sealed block and take it from the cache
+        std::lock_guard<std::mutex> lock(mutex);
+        if (id >= open_first) {
+            if (id - open_first >= open_records.size()) {
+                throw std::out_of_range("DocStore::fetch of a document never appended");
+            }
+            ++hit_count;
+            decode(open_data.data() + open_records[id - open_first], article);
+            return article;
+        }
+        auto position = std::upper_bound(blocks.cbegin(), blocks.cend(), id,
+                                         [](DocId value, const Block &block) { return value < block.first; });
+        number = static_cast<size_t>(position - blocks.cbegin()) - 1;
+        auto entry = cached.find(number);
+        if (entry != cached.end()) {
+            cache.splice(cache.begin(), cache, entry->second);
+            ++hit_count;
+            found = cache.front();
+        } else {
+            ++miss_count;
+            block = blocks[number];
+            end = number + 1 < blocks.size() ? blocks[number + 1].first : open_first;
+        }
+    }
+
+    if (found == nullptr) {
+        //2- Read and decompress a missing block without the mutex, then cache it unless another fetch just did
+        found = load(number, block, end);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = cached.find(number);
+        if (entry != cached.end()) {
+            cache.splice(cache.begin(), cache, entry->second);
+        } else {
+            if (cache.size() >= cache_blocks) {
+                cached.erase(cache.back()->number);
+                cache.pop_back();
+            }
+            cache.push_front(found);
+            cached[number] = cache.begin();
+        }
+    }
+
+    //3- Sealed blocks never change, so the record is decoded without the mutex
+    decode(found->data.data() + found->records[id - found->first], article);
+    return article;
+}
+
+uint64_t DocStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return raw_bytes;
+}
+
+uint64_t DocStore::stored_size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file_size + open_data.size();
+}
+
+uint64_t DocStore::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+uint64_t DocStore::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
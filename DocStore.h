@@ -0,0 +1,122 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       DocStore.h
+ * @date:           10-19-2026
+ * @description:    On-disk store of the indexed articles' bodies, so they do not stay resident.
+ *                      - Documents are appended in DocId order into an open block of records (uuid, title,
+ *                        text, persons, organizations, publication time, site, language)
+ *                      - Once the open block holds "block_bytes", it is compressed (Lz) and appended to the
+ *                        store file; only its first DocId and file offset stay in memory
+ *                      - fetch() finds the block by binary search and decompresses it through a small LRU
+ *                        cache of blocks, so neighbouring documents (a page of results) cost one read
+ *                  The store is append-only: deleted and replaced documents keep their records. Ingest appends
+ *                  while searches fetch, so every member takes the store's mutex, but only to touch the block
+ *                  list and the cache: a missing block is read (pread on a descriptor of its own) and
+ *                  decompressed without it, so fetches of different blocks run side by side.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_DOCSTORE_H
+#define INC_22S_FINAL_PROJ_DOCSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Article.h"
+#include "Segment.h"
+
+class DocStore {
+private:
+    struct Block {
+        DocId first;
+        uint64_t offset;
+        uint32_t compressed_size;
+        uint32_t raw_size;
+    };
+
+    struct CachedBlock {
+        size_t number;
+        DocId first;
+        std::vector<uint8_t> data;
+        //Offset of each record in "data"
+        std::vector<uint32_t> records;
+    };
+
+    mutable std::mutex mutex;
+    std::filesystem::path path;
+    bool temporary;
+    std::fstream file;
+    //Read-only descriptor fetches read sealed blocks through, without the writer's stream position
+    int reader = -1;
+    uint64_t file_size = 0;
+    size_t block_bytes;
+    size_t cache_blocks;
+
+    //Sealed blocks, by first DocId
+    std::vector<Block> blocks;
+    //Records not sealed yet, from DocId "open_first" on
+    DocId open_first = 0;
+    std::vector<uint8_t> open_data;
+    std::vector<uint32_t> open_records;
+    uint64_t raw_bytes = 0;
+
+    //Most recently used first. Fetches keep using a block evicted while they decode it
+    mutable std::list<std::shared_ptr<const CachedBlock>> cache;
+    mutable std::unordered_map<size_t, std::list<std::shared_ptr<const CachedBlock>>::iterator> cached;
+    mutable uint64_t hit_count = 0;
+    mutable uint64_t miss_count = 0;
+
+    /// \description        -> Compresses the open block and appends it to the file. Caller holds the mutex
+    void seal();
+
+    /// \param number       -> Sealed block to read
+    /// \param block        -> Its entry in "blocks"
+    /// \param end          -> First DocId after its records
+    /// \return CachedBlock -> The block, read and decompressed. Called without the mutex
+    std::shared_ptr<const CachedBlock> load(size_t number, const Block &block, DocId end) const;
+
+    /// \param record       -> First byte of a record
+    /// \param article      -> Receives it
+    static void decode(const uint8_t *record, Article &article);
+
+public:
+    /// \param path         -> Store file to create (truncated if it exists). Empty means a temporary file, removed
+    ///                     with the store
+    /// \param block_bytes  -> Uncompressed bytes of records packed into one block
+    /// \param cache_blocks -> Decompressed blocks kept in memory
+    explicit DocStore(std::filesystem::path path = {}, size_t block_bytes = size_t(32) << 10,
+                      size_t cache_blocks = 64);
+
+    DocStore(const DocStore &) = delete;
+
+    DocStore &operator=(const DocStore &) = delete;
+
+    ~DocStore();
+
+    /// \param id           -> DocId of the article: the one after the previously appended article's
+    /// \param article      -> Article to store
+    void append(DocId id, const Article &article);
+
+    /// \param id           -> DocId of an appended article
+    /// \return Article     -> Its stored uuid, title, text and entity names
+    Article fetch(DocId id) const;
+
+    /// \return uint64_t    -> Bytes of records appended
+    uint64_t size() const;
+
+    /// \return uint64_t    -> Bytes they take once compressed, open block included
+    uint64_t stored_size() const;
+
+    /// \return uint64_t    -> Fetches served from a cached (or the open) block
+    uint64_t hits() const;
+
+    /// \return uint64_t    -> Fetches that had to read and decompress a block
+    uint64_t misses() const;
+};
+
+#endif //INC_22S_FINAL_PROJ_DOCSTORE_H
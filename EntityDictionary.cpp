@@ -0,0 +1,109 @@
+#include "EntityDictionary.h"
+
+#include <algorithm>
+#include <cctype>
+
+std::string EntityDictionary::normalize(const std::string &name) {
+    std::string normalized;
+    normalized.reserve(name.size());
+    bool space = false;
+    for (char c: name) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) {
+            normalized.push_back(' ');
+            space = false;
+        }
+        normalized.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    return normalized;
+}
+
+EntityIds EntityDictionary::acquire(const Article &article) {
+    EntityIds ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        Kind &kind = kinds[k];
+        for (const std::string &name: names_of(article, static_cast<Entity>(k))) {
+            auto [entry, inserted] = kind.ids.try_emplace(name, static_cast<EntityId>(kind.documents.size()));
+            if (inserted) {
+                kind.documents.push_back(0);
+                kind.names.push_back(&entry->first);
+            }
+            ids[k].push_back(entry->second);
+        }
+        //An entity can be tagged several times in one article
+        std::sort(ids[k].begin(), ids[k].end());
+        ids[k].erase(std::unique(ids[k].begin(), ids[k].end()), ids[k].end());
+        for (EntityId id: ids[k]) {
+            if (kind.documents[id]++ == 0) {
+                ++kind.live;
+            }
+        }
+    }
+    return ids;
+}
+
+void EntityDictionary::release(const Article &article) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        Kind &kind = kinds[k];
+        std::vector<EntityId> ids;
+        for (const std::string &name: names_of(article, static_cast<Entity>(k))) {
+            auto entry = kind.ids.find(name);
+            if (entry != kind.ids.end()) {
+                ids.push_back(entry->second);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        for (EntityId id: ids) {
+            if (kind.documents[id] != 0 && --kind.documents[id] == 0) {
+                --kind.live;
+            }
+        }
+    }
+}
+
+std::vector<EntityId> EntityDictionary::lookup(Entity kind, const std::string &name, bool prefix) const {
+    std::string key = normalize(name);
+    std::vector<EntityId> ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    const Kind &entities = kinds[static_cast<size_t>(kind)];
+    if (!prefix) {
+        auto entry = entities.ids.find(key);
+        if (entry != entities.ids.end()) {
+            ids.push_back(entry->second);
+        }
+        return ids;
+    }
+    for (auto entry = entities.ids.lower_bound(key);
+         entry != entities.ids.end() && entry->first.compare(0, key.size(), key) == 0; ++entry) {
+        ids.push_back(entry->second);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+uint32_t EntityDictionary::documents(Entity kind, EntityId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Kind &entities = kinds[static_cast<size_t>(kind)];
+    return id < entities.documents.size() ? entities.documents[id] : 0;
+}
+
+size_t EntityDictionary::size(Entity kind) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return kinds[static_cast<size_t>(kind)].live;
+}
+
+size_t EntityDictionary::id_count(Entity kind) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return kinds[static_cast<size_t>(kind)].documents.size();
+}
+
+std::string EntityDictionary::name(Entity kind, EntityId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return *kinds[static_cast<size_t>(kind)].names[id];
+}
@@ -0,0 +1,94 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       EntityDictionary.h
+ * @date:           10-19-2026
+ * @description:    Index-wide dictionary of the entities (organizations, persons) articles are tagged with.
+ *                  Normalized names are interned to dense ids at ingest, one id space per kind, and the
+ *                  segments key their entity postings by id. The dictionary counts the live documents
+ *                  tagged with each entity and answers exact and prefix lookups by name; names are
+ *                  normalized on both sides, so lookups are case-insensitive.
+ *                  Ingest interns while queries look up, so every member takes the dictionary's mutex.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_ENTITYDICTIONARY_H
+#define INC_22S_FINAL_PROJ_ENTITYDICTIONARY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Article.h"
+
+/// \description Kinds of entities an article can be tagged with
+enum class Entity : uint8_t {
+    ORGANIZATION,
+    PERSON,
+};
+constexpr size_t ENTITY_KIND_COUNT = 2;
+
+/// \description Interned entity name, dense per kind
+using EntityId = uint32_t;
+
+/// \description ids[kind] -> distinct ids of the entities of that kind an article is tagged with, ascending
+using EntityIds = std::array<std::vector<EntityId>, ENTITY_KIND_COUNT>;
+
+class EntityDictionary {
+private:
+    struct Kind {
+        //name -> id, in name order so prefixes are contiguous
+        std::map<std::string, EntityId> ids;
+        //id -> number of live documents tagged with it
+        std::vector<uint32_t> documents;
+        //id -> its name (a key of "ids")
+        std::vector<const std::string *> names;
+        //Entities with at least one live document
+        size_t live = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::array<Kind, ENTITY_KIND_COUNT> kinds;
+
+public:
+    /// \param name         -> Entity name as tagged or typed, e.g. "  Goldman   SACHS"
+    /// \return string      -> The name entities are interned under: lowercase, single-spaced, trimmed
+    static std::string normalize(const std::string &name);
+
+    /// \param article      -> Parsed article
+    /// \param kind         -> Kind of entity
+    /// \return vector      -> The article's entity names of that kind
+    static const std::vector<std::string> &names_of(const Article &article, Entity kind) {
+        return kind == Entity::PERSON ? article.persons : article.organizations;
+    }
+
+    /// \param article      -> Article being indexed; its names are expected to be normalized
+    /// \return EntityIds   -> Ids of its entities, interned if new. The article counts as a live document of each
+    EntityIds acquire(const Article &article);
+
+    /// \param article      -> Article that was acquired and is now deleted or replaced
+    /// \description        -> Stops counting it as a live document of its entities
+    void release(const Article &article);
+
+    /// \param kind         -> Kind of entity
+    /// \param name         -> Name to look up, normalized here
+    /// \param prefix       -> Match every entity whose name starts with "name" instead of exactly "name"
+    /// \return vector      -> Ids of every matching entity, ascending. Entities whose documents were all deleted are
+    ///                     kept: a snapshot may still hold those documents, and its tombstones decide what matches
+    std::vector<EntityId> lookup(Entity kind, const std::string &name, bool prefix) const;
+
+    /// \return uint32_t    -> Number of live documents tagged with entity "id"
+    uint32_t documents(Entity kind, EntityId id) const;
+
+    /// \return size_t      -> Number of distinct entities of "kind" tagged in live documents
+    size_t size(Entity kind) const;
+
+    /// \return size_t      -> Number of ids interned for "kind" so far: every id of that kind is below it
+    size_t id_count(Entity kind) const;
+
+    /// \return string      -> Normalized name of entity "id"
+    std::string name(Entity kind, EntityId id) const;
+};
+
+#endif //INC_22S_FINAL_PROJ_ENTITYDICTIONARY_H
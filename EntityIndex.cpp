@@ -0,0 +1,106 @@
+#include "EntityIndex.h"
+
+#include <algorithm>
+#include "Positions.h"
+
+EntityIndex::EntityIndex(EntityPostings &&postings) {
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        //std::map iterates in id order, so the ids come out ascending
+        Kind &kind = kinds[k];
+        //1- Forward column: bucket the ids by ordinal. Ids come in ascending order, so every bucket is sorted
+        size_t documents = 0;
+        for (const auto &entry: postings[k]) {
+            if (!entry.second.empty()) documents = std::max(documents, static_cast<size_t>(entry.second.back()) + 1);
+        }
+        std::vector<uint32_t> starts(documents + 1, 0);
+        for (const auto &entry: postings[k]) {
+            for (uint32_t ordinal: entry.second) ++starts[ordinal + 1];
+        }
+        for (size_t i = 1; i < starts.size(); ++i) {
+            starts[i] += starts[i - 1];
+        }
+        std::vector<EntityId> buckets(starts.back());
+        std::vector<uint32_t> next(starts.cbegin(), starts.cend() - 1);
+        for (const auto &[id, ordinals]: postings[k]) {
+            for (uint32_t ordinal: ordinals) buckets[next[ordinal]++] = id;
+        }
+        kind.offsets.reserve(documents + 1);
+        for (size_t ordinal = 0; ordinal < documents; ++ordinal) {
+            kind.offsets.push_back(static_cast<uint32_t>(kind.tags.size()));
+            EntityId previous = 0;
+            for (uint32_t i = starts[ordinal]; i < starts[ordinal + 1]; ++i) {
+                Positions::put_varint(kind.tags, buckets[i] - previous);
+                previous = buckets[i];
+            }
+        }
+        if (documents != 0) {
+            kind.offsets.push_back(static_cast<uint32_t>(kind.tags.size()));
+        }
+        kind.tags.shrink_to_fit();
+
+        //2- Postings
+        kind.ids.reserve(postings[k].size());
+        kind.counts.reserve(postings[k].size());
+        kind.sets.reserve(postings[k].size());
+        for (const auto &[id, ordinals]: postings[k]) {
+            std::vector<uint8_t> blob;
+            uint32_t previous = 0;
+            for (uint32_t ordinal: ordinals) {
+                Positions::put_varint(blob, ordinal - previous);
+                previous = ordinal;
+            }
+            blob.shrink_to_fit();
+            kind.ids.push_back(id);
+            kind.sets.push_back(std::move(blob));
+            kind.counts.push_back(static_cast<uint32_t>(ordinals.size()));
+        }
+        postings[k].clear();
+    }
+}
+
+void EntityIndex::add(EntityPostings &postings, const EntityIds &ids, uint32_t local) {
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        for (EntityId id: ids[k]) {
+            postings[k][id].push_back(local);
+        }
+    }
+}
+
+const std::vector<uint8_t> *EntityIndex::set(Entity kind, EntityId id) const {
+    const Kind &entities = kinds[static_cast<size_t>(kind)];
+    auto position = std::lower_bound(entities.ids.cbegin(), entities.ids.cend(), id);
+    if (position == entities.ids.cend() || *position != id) {
+        return nullptr;
+    }
+    return &entities.sets[static_cast<size_t>(position - entities.ids.cbegin())];
+}
+
+uint32_t EntityIndex::documents(Entity kind, EntityId id) const {
+    const Kind &entities = kinds[static_cast<size_t>(kind)];
+    auto position = std::lower_bound(entities.ids.cbegin(), entities.ids.cend(), id);
+    if (position == entities.ids.cend() || *position != id) {
+        return 0;
+    }
+    return entities.counts[static_cast<size_t>(position - entities.ids.cbegin())];
+}
+
+bool EntityIndex::postings(Entity kind, EntityId id, std::vector<uint32_t> &ordinals) const {
+    const std::vector<uint8_t> *blob = set(kind, id);
+    if (blob == nullptr) {
+        ordinals.clear();
+        return false;
+    }
+    decode(*blob, ordinals);
+    return true;
+}
+
+void EntityIndex::decode(const std::vector<uint8_t> &blob, std::vector<uint32_t> &ordinals) {
+    ordinals.clear();
+    const uint8_t *data = blob.data();
+    const uint8_t *end = data + blob.size();
+    uint32_t previous = 0;
+    while (data != end) {
+        previous += static_cast<uint32_t>(Positions::get_varint(data));
+        ordinals.push_back(previous);
+    }
+}
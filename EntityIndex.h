@@ -0,0 +1,102 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       EntityIndex.h
+ * @date:           10-19-2026
+ * @description:    Entity postings of a segment. For each kind of entity (organizations, persons) it maps an
+ *                  interned entity (see EntityDictionary) to the set of local ordinals of the documents
+ *                  tagged with it. Each set is kept compressed (varint deltas) and only decoded when a query
+ *                  filters on that entity.
+ *                  A forward column holds the same tags the other way around, for facet counting: the ascending
+ *                  entity ids of every local ordinal, as varint deltas in one byte array with an offset per
+ *                  ordinal.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_ENTITYINDEX_H
+#define INC_22S_FINAL_PROJ_ENTITYINDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "EntityDictionary.h"
+#include "Positions.h"
+
+/// \description postings[kind]: entity id -> ascending local ordinals
+using EntityPostings = std::array<std::map<EntityId, std::vector<uint32_t>>, ENTITY_KIND_COUNT>;
+
+class EntityIndex {
+private:
+    struct Kind {
+        //Ascending entity ids, the varint deltas of each one's ordinals, and how many ordinals that is
+        std::vector<EntityId> ids;
+        std::vector<std::vector<uint8_t>> sets;
+        std::vector<uint32_t> counts;
+        //Forward column: the ids of ordinal i are the varint deltas in tags[offsets[i], offsets[i + 1]).
+        //Ordinals past the last tagged one have no entry
+        std::vector<uint32_t> offsets;
+        std::vector<uint8_t> tags;
+    };
+    std::array<Kind, ENTITY_KIND_COUNT> kinds;
+
+public:
+    EntityIndex() = default;
+
+    /// \param postings     -> Ordinals of every entity, compressed into the index
+    explicit EntityIndex(EntityPostings &&postings);
+
+    /// \param postings     -> Postings being built
+    /// \param ids          -> Entities of the document
+    /// \param local        -> Local ordinal of the document, greater than every ordinal added before
+    static void add(EntityPostings &postings, const EntityIds &ids, uint32_t local);
+
+    /// \param kind         -> Kind of entity
+    /// \param id           -> Entity to look up
+    /// \return vector*     -> Compressed ordinals of the documents tagged with it (see decode), or nullptr
+    const std::vector<uint8_t> *set(Entity kind, EntityId id) const;
+
+    /// \param kind         -> Kind of entity
+    /// \param id           -> Entity to look up
+    /// \return uint32_t    -> Number of documents of the segment tagged with it, deleted ones included
+    uint32_t documents(Entity kind, EntityId id) const;
+
+    /// \param kind         -> Kind of entity
+    /// \param id           -> Entity to look up
+    /// \param ordinals     -> Receives the ascending local ordinals of the documents tagged with it
+    /// \return bool        -> Whether any document is
+    bool postings(Entity kind, EntityId id, std::vector<uint32_t> &ordinals) const;
+
+    /// \param kind         -> Kind of entity
+    /// \param f            -> Called with (entity id, ascending local ordinals) for every entity of that kind
+    template<typename F>
+    void for_each(Entity kind, F &&f) const {
+        const Kind &entities = kinds[static_cast<size_t>(kind)];
+        std::vector<uint32_t> ordinals;
+        for (size_t i = 0; i < entities.ids.size(); ++i) {
+            decode(entities.sets[i], ordinals);
+            f(entities.ids[i], ordinals);
+        }
+    }
+
+    /// \param kind         -> Kind of entity
+    /// \param local        -> Local ordinal of a document
+    /// \param f            -> Called with the id of every entity of that kind the document is tagged with, ascending
+    template<typename F>
+    void for_each_tag(Entity kind, uint32_t local, F &&f) const {
+        const Kind &entities = kinds[static_cast<size_t>(kind)];
+        if (static_cast<size_t>(local) + 1 >= entities.offsets.size()) return;
+        const uint8_t *data = entities.tags.data() + entities.offsets[local];
+        const uint8_t *end = entities.tags.data() + entities.offsets[local + 1];
+        EntityId id = 0;
+        while (data != end) {
+            id += static_cast<EntityId>(Positions::get_varint(data));
+            f(id);
+        }
+    }
+
+    /// \param blob         -> Varint deltas
+    /// \param ordinals     -> Receives the ordinals they encode
+    static void decode(const std::vector<uint8_t> &blob, std::vector<uint32_t> &ordinals);
+};
+
+#endif //INC_22S_FINAL_PROJ_ENTITYINDEX_H
@@ -0,0 +1,68 @@
+#include "Facets.h"
+
+#include <algorithm>
+
+FacetCounter::FacetCounter(Entity kind, size_t id_count, size_t matches, size_t sample_limit)
+        : kind(kind), matches(matches) {
+    //1- Count every stride-th match, so that no more than "sample_limit" are counted
+    stride = sample_limit == 0 || matches <= sample_limit ? 1 : (matches + sample_limit - 1) / sample_limit;
+    //2- A flat array pays for the whole dictionary; sparse counters only for the tags met
+    size_t documents = (matches + stride - 1) / stride;
+    dense = documents * SPARSE_RATIO >= id_count;
+    if (dense) {
+        counts.assign(id_count, 0);
+    }
+}
+
+void FacetCounter::add(const EntityIndex &entities, uint32_t local) {
+    if (seen++ % stride != 0) {
+        return;
+    }
+    ++counted;
+    if (dense) {
+        entities.for_each_tag(kind, local, [this](EntityId id) {
+            if (counts[id]++ == 0) touched.push_back(id);
+        });
+    } else {
+        entities.for_each_tag(kind, local, [this](EntityId id) { touched.push_back(id); });
+    }
+}
+
+FacetCounts FacetCounter::top(size_t n, const EntityDictionary &dictionary) const {
+    //1- (id, count) of every entity met
+    std::vector<std::pair<EntityId, size_t>> totals;
+    if (dense) {
+        totals.reserve(touched.size());
+        for (EntityId id: touched) {
+            totals.emplace_back(id, counts[id]);
+        }
+    } else {
+        std::vector<EntityId> ids(touched);
+        std::sort(ids.begin(), ids.end());
+        for (size_t i = 0; i < ids.size();) {
+            size_t run = i;
+            while (run < ids.size() && ids[run] == ids[i]) ++run;
+            totals.emplace_back(ids[i], run - i);
+            i = run;
+        }
+    }
+
+    //2- The n largest, then their names
+    auto more_frequent = [](const auto &a, const auto &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    };
+    size_t kept = std::min(n, totals.size());
+    std::partial_sort(totals.begin(), totals.begin() + static_cast<long>(kept), totals.end(), more_frequent);
+    FacetCounts facets;
+    facets.matches = matches;
+    facets.counted = counted;
+    facets.top.reserve(kept);
+    for (size_t i = 0; i < kept; ++i) {
+        //Sampled counts are scaled by the share of the matches that was counted
+        size_t count = counted == matches ? totals[i].second : static_cast<size_t>(
+                static_cast<double>(totals[i].second) * static_cast<double>(matches) / static_cast<double>(counted) +
+                0.5);
+        facets.top.push_back({totals[i].first, dictionary.name(kind, totals[i].first), count});
+    }
+    return facets;
+}
@@ -0,0 +1,77 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Facets.h
+ * @date:           10-19-2026
+ * @description:    Facet counting: how many documents of a result set are tagged with each organization or
+ *                  person, and the top ones. A FacetCounter reads the entity ids of every match from its
+ *                  segment's forward column (EntityIndex::for_each_tag), so no name is read or hashed until the
+ *                  top entities are known. Counts go to
+ *                      - a flat array indexed by entity id, when the matches are many compared to the dictionary
+ *                      - sparse counters otherwise: the ids are collected, sorted and counted by runs
+ *                  Result sets larger than the sample limit are sampled: every n-th match is counted and the
+ *                  counts are scaled back up.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_FACETS_H
+#define INC_22S_FINAL_PROJ_FACETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EntityDictionary.h"
+#include "EntityIndex.h"
+
+/// \description An entity and the number of matching documents tagged with it
+struct Facet {
+    EntityId id;
+    std::string name;
+    size_t count;
+};
+
+/// \description Top entities of one kind over a result set
+struct FacetCounts {
+    /// \description At most n entities, most frequent first (ties by ascending id)
+    std::vector<Facet> top;
+    /// \description Number of matching documents
+    size_t matches = 0;
+    /// \description Number of them whose tags were counted. When fewer than "matches", counts are estimates
+    size_t counted = 0;
+};
+
+class FacetCounter {
+public:
+    static constexpr size_t DEFAULT_SAMPLE_LIMIT = 100000;
+
+private:
+    /// \description Flat counters are used when there are at least 1 / SPARSE_RATIO counted documents per entity
+    static constexpr size_t SPARSE_RATIO = 16;
+
+    Entity kind;
+    size_t matches;
+    size_t stride;
+    size_t seen = 0;
+    size_t counted = 0;
+    bool dense;
+    //Flat counters by id, and the ids whose counter left 0 (dense); every id met, repeats included (sparse)
+    std::vector<uint32_t> counts;
+    std::vector<EntityId> touched;
+
+public:
+    /// \param kind         -> Kind of entity to count
+    /// \param id_count     -> Every entity id of that kind is below it (EntityDictionary::id_count)
+    /// \param matches      -> Number of documents that will be added
+    /// \param sample_limit -> Most documents to count; above it only every n-th added document is. 0 never samples
+    FacetCounter(Entity kind, size_t id_count, size_t matches, size_t sample_limit = DEFAULT_SAMPLE_LIMIT);
+
+    /// \param entities     -> Entity index of the document's segment
+    /// \param local        -> Local ordinal of a matching document
+    void add(const EntityIndex &entities, uint32_t local);
+
+    /// \param n            -> Number of entities wanted
+    /// \param dictionary   -> Dictionary the ids were interned in, to name the top entities
+    /// \return FacetCounts -> The n most frequent entities. Sampled counts are scaled by the sampling stride
+    FacetCounts top(size_t n, const EntityDictionary &dictionary) const;
+};
+
+#endif //INC_22S_FINAL_PROJ_FACETS_H
@@ -0,0 +1,158 @@
+#include "FeedIngestor.h"
+
+#include <iostream>
+#include <vector>
+#include "Parser.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+FeedIngestor::FeedIngestor(FeedConfig config, Index &index, ThreadPool &pool) : config(std::move(config)),
+                                                                                index(index),
+                                                                                parse_tasks(pool) {
+    if (!this->config.feed_path.empty()) {
+        feed_thread = std::thread(&FeedIngestor::read_feed, this);
+    } else {
+        feed_finished = true;
+    }
+    if (!this->config.spool_path.empty()) {
+        spool_thread = std::thread(&FeedIngestor::watch_spool, this);
+    }
+    refresh_thread = std::thread(&FeedIngestor::refresh_loop, this);
+}
+
+FeedIngestor::~FeedIngestor() {
+    stop();
+}
+
+void FeedIngestor::stop() {
+    if (stopping.exchange(true)) {
+        return;
+    }
+    refresh_condition.notify_all();
+    if (feed_thread.joinable()) feed_thread.join();
+    if (spool_thread.joinable()) spool_thread.join();
+    if (refresh_thread.joinable()) refresh_thread.join();
+    parse_tasks.wait();
+    index.flush();
+}
+
+void FeedIngestor::submit(std::string &&json) {
+    uint64_t sequence;
+    {
+        //The feed and the spool threads both submit
+        std::lock_guard<std::mutex> lock(apply_mutex);
+        sequence = next_sequence++;
+    }
+    parse_tasks.run([this, sequence, json = std::move(json)] {
+        Parsed record;
+        record.article = Parser::parse_json_string(json);
+        if (record.article == nullptr && !Parser::parse_retraction(json, record.retracted)) {
+            ++malformed_records;
+        }
+        apply(sequence, std::move(record));
+    });
+}
+
+void FeedIngestor::apply(uint64_t sequence, Parsed &&record) {
+    std::lock_guard<std::mutex> lock(apply_mutex);
+    parsed.emplace(sequence, std::move(record));
+    //The task that parses record "next_apply" applies it and the parsed records that follow it
+    for (auto next = parsed.begin(); next != parsed.end() && next->first == next_apply; next = parsed.begin()) {
+        if (next->second.article != nullptr) {
+            index.add(next->second.article);
+            ++articles_ingested;
+        } else if (!next->second.retracted.empty() && index.remove(next->second.retracted)) {
+            ++articles_retracted;
+        }
+        parsed.erase(next);
+        ++next_apply;
+    }
+}
+
+void FeedIngestor::read_feed() {
+    bool from_stdin = config.feed_path == "-";
+    //Non-blocking descriptor + poll, so stop() is never stuck behind a read
+    int fd = from_stdin ? STDIN_FILENO : ::open(config.feed_path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "Cannot open feed " << config.feed_path << '\n';
+        feed_finished = true;
+        return;
+    }
+
+    std::string pending;
+    std::vector<char> chunk(1 << 16);
+    while (!stopping) {
+        pollfd descriptor{fd, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, static_cast<int>(config.poll_interval.count()));
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t bytes = ::read(fd, chunk.data(), chunk.size());
+        if (bytes < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            break;
+        }
+        if (bytes == 0) {
+            if (from_stdin) {
+                break;
+            }
+            //End of a followed file, or every writer left the pipe: wait for more data
+            std::this_thread::sleep_for(config.poll_interval);
+            continue;
+        }
+        pending.append(chunk.data(), static_cast<size_t>(bytes));
+        size_t line_start = 0;
+        for (size_t newline = pending.find('\n'); newline != std::string::npos;
+             newline = pending.find('\n', line_start)) {
+            if (newline > line_start) {
+                submit(pending.substr(line_start, newline - line_start));
+            }
+            line_start = newline + 1;
+        }
+        pending.erase(0, line_start);
+    }
+    if (!pending.empty() && from_stdin) {
+        submit(std::move(pending));
+    }
+    if (!from_stdin) {
+        ::close(fd);
+    }
+    feed_finished = true;
+    refresh_condition.notify_all();
+}
+
+void FeedIngestor::watch_spool() {
+    std::unordered_set<std::string> seen;
+    while (!stopping) {
+        std::error_code error;
+        for (const auto &entry: std::filesystem::directory_iterator(config.spool_path, error)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json") {
+                continue;
+            }
+            if (!seen.insert(entry.path().string()).second) {
+                continue;
+            }
+            std::ifstream file(entry.path());
+            std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            submit(std::move(json));
+        }
+        std::unique_lock<std::mutex> lock(refresh_mutex);
+        refresh_condition.wait_for(lock, config.poll_interval, [this] { return stopping.load(); });
+    }
+}
+
+void FeedIngestor::refresh_loop() {
+    std::unique_lock<std::mutex> lock(refresh_mutex);
+    while (!stopping) {
+        refresh_condition.wait_for(lock, config.refresh_interval, [this] { return stopping.load(); });
+        lock.unlock();
+        index.flush();
+        lock.lock();
+    }
+}
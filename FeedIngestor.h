@@ -0,0 +1,121 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       FeedIngestor.h
+ * @date:           10-19-2026
+ * @description:    Near-real-time ingest of a live article feed into a running Index.
+ *                      - Feed: JSON lines from stdin ("-"), a regular file (followed like tail -f)
+ *                        or a named pipe (writers may come and go)
+ *                      - Spool: a directory polled for new Kaggle-style ".json" files
+ *                  A record repeating an indexed uuid replaces that article; {"uuid": "...", "deleted": true}
+ *                  retracts it. Records are parsed on the ingest pool in parallel but applied in the order
+ *                  they were read, so a retraction or an update never loses to an older record of its uuid
+ *                  that took longer to parse. Articles are buffered by the Index; a refresher
+ *                  thread flushes the buffer every refresh interval, which publishes a new
+ *                  generation without blocking queries running against older ones.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_FEEDINGESTOR_H
+#define INC_22S_FINAL_PROJ_FEEDINGESTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include "Index.h"
+#include "Parallel.h"
+
+struct FeedConfig {
+    /// \description JSON-lines source: "-" for stdin, a file or a named pipe. Empty disables it
+    std::string feed_path;
+    /// \description Directory polled for new ".json" files. Empty disables it. Producers should write to
+    ///              a temporary name and rename to ".json", so half-written files are never picked up
+    std::string spool_path;
+    /// \description How often buffered articles are published to searchers
+    std::chrono::milliseconds refresh_interval{1000};
+    /// \description How often the spool directory is scanned, and how long an idle feed is polled for
+    std::chrono::milliseconds poll_interval{100};
+};
+
+class FeedIngestor {
+private:
+    FeedConfig config;
+    Index &index;
+    TaskGroup parse_tasks;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> feed_finished{false};
+    std::atomic<size_t> articles_ingested{0};
+    std::atomic<size_t> malformed_records{0};
+    std::atomic<size_t> articles_retracted{0};
+
+    //A parsed record waiting for the ones read before it: an article to add, a uuid to retract, or neither
+    struct Parsed {
+        Article *article = nullptr;
+        std::string retracted;
+    };
+    std::mutex apply_mutex;
+    uint64_t next_sequence = 0;
+    uint64_t next_apply = 0;
+    std::map<uint64_t, Parsed> parsed;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_condition;
+
+    std::thread feed_thread;
+    std::thread spool_thread;
+    std::thread refresh_thread;
+
+    /// \param json         -> One JSON article
+    /// \description        -> Parses "json" on the pool and adds the result to the index (or retracts), once
+    ///                     every record submitted before it is applied
+    void submit(std::string &&json);
+
+    /// \param sequence     -> Number submit() gave the record
+    /// \param record       -> What parsing it gave
+    /// \description        -> Applies it and every following record already parsed, if the ones before are
+    void apply(uint64_t sequence, Parsed &&record);
+
+    /// \description        -> Reads the feed line by line until stopped (or until EOF on stdin)
+    void read_feed();
+
+    /// \description        -> Picks up spool files that were not seen before, until stopped
+    void watch_spool();
+
+    /// \description        -> Flushes the index buffer every refresh interval, until stopped
+    void refresh_loop();
+
+public:
+    /// \param config       -> Sources and intervals
+    /// \param index        -> Index the articles are added to
+    /// \param pool         -> Pool the articles are parsed on
+    /// \description        -> Starts reading the configured sources right away
+    FeedIngestor(FeedConfig config, Index &index, ThreadPool &pool);
+
+    FeedIngestor(const FeedIngestor &) = delete;
+
+    FeedIngestor &operator=(const FeedIngestor &) = delete;
+
+    /// \description        -> Stops the sources, waits for articles being parsed and publishes them
+    ~FeedIngestor();
+
+    /// \description        -> Same as the destructor, can be called early
+    void stop();
+
+    /// \return bool        -> True once a feed on stdin reached EOF (other sources never finish)
+    bool finished() const { return feed_finished.load(); }
+
+    size_t ingested() const { return articles_ingested.load(); }
+
+    size_t malformed() const { return malformed_records.load(); }
+
+    size_t retracted() const { return articles_retracted.load(); }
+};
+
+#endif //INC_22S_FINAL_PROJ_FEEDINGESTOR_H
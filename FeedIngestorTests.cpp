@@ -0,0 +1,71 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       FeedIngestorTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the live feed: records of one uuid take effect in feed order, even when the older
+ *                  record is much slower to parse than the retraction or the update that follows it.
+ */
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "FeedIngestor.h"
+
+/// \param index        -> Uuid of the article, 40 hex digits
+/// \return string      -> The uuid of test article "index"
+static std::string feed_uuid(size_t index) {
+    std::string uuid = std::to_string(index);
+    return std::string(40 - uuid.size(), 'a') + uuid;
+}
+
+TEST_CASE("FeedIngestor applies the records of a uuid in feed order", "[FeedIngestor]") {
+    //1- Every article comes first in a long version; the even ones are then retracted, the odd ones updated
+    constexpr size_t ARTICLES = 16;
+    std::string long_text;
+    while (long_text.size() < (size_t(1) << 20)) long_text += "markets rallied as the first version went out ";
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "googleyes-feed-test.jsonl";
+    {
+        std::ofstream feed(path, std::ios::trunc);
+        for (size_t i = 0; i < ARTICLES; ++i) {
+            feed << R"({"uuid": ")" << feed_uuid(i) << R"(", "text": ")" << long_text << "\"}\n";
+            if (i % 2 == 0) {
+                feed << R"({"uuid": ")" << feed_uuid(i) << R"(", "deleted": true})" << '\n';
+            } else {
+                feed << R"({"uuid": ")" << feed_uuid(i) << R"(", "text": "second version )" << i << "\"}\n";
+            }
+        }
+    }
+
+    //2- Ingest the file until every add and retraction took effect (or give up)
+    ThreadPool pool(4);
+    Index index;
+    FeedConfig config;
+    config.feed_path = path.string();
+    config.poll_interval = std::chrono::milliseconds(10);
+    FeedIngestor ingestor(config, index, pool);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while ((ingestor.ingested() < ARTICLES + ARTICLES / 2 || ingestor.retracted() < ARTICLES / 2) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ingestor.stop();
+    std::filesystem::remove(path);
+
+    CHECK(ingestor.ingested() == ARTICLES + ARTICLES / 2);
+    CHECK(ingestor.retracted() == ARTICLES / 2);
+    CHECK(ingestor.malformed() == 0);
+    for (size_t i = 0; i < ARTICLES; ++i) {
+        DocId id = index.find(feed_uuid(i));
+        if (i % 2 == 0) {
+            CHECK(id == UuidIndex::NONE);
+        } else {
+            REQUIRE(id != UuidIndex::NONE);
+            //Only the head of the text, so a stale long version fails with a short message
+            CHECK(index.fetch(id).text.substr(0, 64) == "second version " + std::to_string(i));
+        }
+    }
+}
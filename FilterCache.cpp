@@ -0,0 +1,74 @@
+#include "FilterCache.h"
+
+#include <iterator>
+
+void FilterCache::advance(uint64_t number) {
+    if (number > generation) {
+        entries.clear();
+        recency.clear();
+        used = 0;
+        generation = number;
+    }
+}
+
+std::shared_ptr<const FilterBitmaps> FilterCache::fetch(const std::string &key, uint64_t number, size_t segments,
+                                                        const std::vector<size_t> &searched,
+                                                        const std::function<Bitmap(size_t)> &build) {
+    //1- Cached, or count the request
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        advance(number);
+        if (number == generation) {
+            auto entry = entries.find(key);
+            if (entry != entries.end()) {
+                recency.splice(recency.begin(), recency, entry->second.recency);
+                hit_count.fetch_add(1, std::memory_order_relaxed);
+                return entry->second.bitmaps;
+            }
+        }
+        miss_count.fetch_add(1, std::memory_order_relaxed);
+        if (requests.size() >= MAX_TRACKED && requests.find(key) == requests.end()) {
+            //Age the counts so that filters popular long ago make room
+            for (auto request = requests.begin(); request != requests.end();) {
+                request->second /= 2;
+                request = request->second == 0 ? requests.erase(request) : std::next(request);
+            }
+        }
+        if (++requests[key] < admission || number != generation) {
+            return nullptr;
+        }
+    }
+
+    //2- Admitted: build it without holding the lock
+    auto bitmaps = std::make_shared<FilterBitmaps>(segments);
+    size_t bytes = 0;
+    for (size_t s: searched) {
+        (*bitmaps)[s] = build(s);
+        bytes += (*bitmaps)[s].bytes();
+    }
+    if (bytes > budget) {
+        return bitmaps;
+    }
+
+    //3- Keep it, unless the generation moved on or another search cached it meanwhile
+    std::lock_guard<std::mutex> lock(mutex);
+    advance(number);
+    if (number != generation || entries.find(key) != entries.end()) {
+        return bitmaps;
+    }
+    while (used + bytes > budget) {
+        auto evicted = entries.find(recency.back());
+        used -= evicted->second.bytes;
+        entries.erase(evicted);
+        recency.pop_back();
+    }
+    recency.push_front(key);
+    entries.emplace(key, Entry{bitmaps, bytes, recency.begin()});
+    used += bytes;
+    return bitmaps;
+}
+
+size_t FilterCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
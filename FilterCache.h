@@ -0,0 +1,89 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       FilterCache.h
+ * @date:           10-19-2026
+ * @description:    Cache of filter clauses (ORG/PERSON, date/site/lang) evaluated into one bitmap of matching
+ *                  ordinals per segment, so that a filter shared by many queries is decoded or scanned once and
+ *                  then joins every AND as a ready-made operand. Filters are admitted once they have been asked
+ *                  for often enough, and the least recently used ones are evicted to stay within a memory budget.
+ *                  Bitmaps belong to one index generation: the first request from a newer generation drops them
+ *                  all (the request counts are kept, so popular filters come back on their next use).
+ */
+
+#ifndef INC_22S_FINAL_PROJ_FILTERCACHE_H
+#define INC_22S_FINAL_PROJ_FILTERCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Bitmap.h"
+
+/// \description bitmaps[s] -> ordinals of segment s that pass the filter
+using FilterBitmaps = std::vector<Bitmap>;
+
+class FilterCache {
+private:
+    /// \description Number of filters whose requests are counted before the counts are aged
+    static constexpr size_t MAX_TRACKED = 4096;
+
+    struct Entry {
+        std::shared_ptr<const FilterBitmaps> bitmaps;
+        size_t bytes;
+        std::list<std::string>::iterator recency;
+    };
+
+    std::mutex mutex;
+    uint64_t generation = 0;
+    std::unordered_map<std::string, Entry> entries;
+    //Cached filters, most recently used first
+    std::list<std::string> recency;
+    std::unordered_map<std::string, uint32_t> requests;
+    size_t budget;
+    size_t used = 0;
+    uint32_t admission;
+    std::atomic<uint64_t> hit_count{0};
+    std::atomic<uint64_t> miss_count{0};
+
+    /// \description        -> Drops the cached bitmaps if "number" is a newer generation. Caller holds the mutex
+    void advance(uint64_t number);
+
+public:
+    /// \param budget       -> Bytes of bitmaps to keep at most
+    /// \param admission    -> Requests a filter needs before its bitmaps are built and kept
+    explicit FilterCache(size_t budget = size_t(64) << 20, uint32_t admission = 2)
+            : budget(budget), admission(admission) {}
+
+    FilterCache(const FilterCache &) = delete;
+
+    FilterCache &operator=(const FilterCache &) = delete;
+
+    /// \param key          -> Canonical filter clause, and whatever decides which segments are searched
+    /// \param number       -> Number of the generation being searched
+    /// \param segments     -> Number of segments in it
+    /// \param searched     -> Ascending positions of the segments to evaluate; the others get an empty bitmap
+    /// \param build        -> Evaluates the filter on segment s of that generation
+    /// \return FilterBitmaps* -> The filter's bitmaps for the generation, built now if the filter has just been
+    ///                     admitted, or nullptr when it is not popular enough yet. Bitmaps larger than the
+    ///                     whole budget are returned for this request but not kept
+    std::shared_ptr<const FilterBitmaps> fetch(const std::string &key, uint64_t number, size_t segments,
+                                               const std::vector<size_t> &searched,
+                                               const std::function<Bitmap(size_t)> &build);
+
+    /// \return uint64_t    -> Requests answered with cached bitmaps
+    uint64_t hits() const { return hit_count.load(std::memory_order_relaxed); }
+
+    /// \return uint64_t    -> Requests that were not (including the one that builds a filter)
+    uint64_t misses() const { return miss_count.load(std::memory_order_relaxed); }
+
+    /// \return size_t      -> Bytes of cached bitmaps
+    size_t size();
+};
+
+#endif //INC_22S_FINAL_PROJ_FILTERCACHE_H
@@ -0,0 +1,485 @@
+#include "Index.h"
+#include "IndexFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+size_t IndexGeneration::doc_count() const {
+    size_t total = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        total += segments[i]->doc_count() - (deletions[i] == nullptr ? 0 : deletions[i]->count());
+    }
+    return total;
+}
+
+size_t IndexGeneration::document_frequency(const std::string &term, Field field) const {
+    size_t frequency = 0;
+    for (const auto &segment: segments) {
+        const std::vector<uint32_t> *list = segment->postings(term, field);
+        frequency += list == nullptr ? 0 : list->size();
+    }
+    return frequency;
+}
+
+DocTable::DocTable() : chunks(new std::atomic<Article **>[MAX_CHUNKS]) {
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+DocTable::~DocTable() {
+    DocId total = count.load(std::memory_order_acquire);
+    for (DocId id = 0; id < total; ++id) {
+        delete get(id);
+    }
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        delete[] chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+DocId DocTable::append(Article *article) {
+    DocId id = count.load(std::memory_order_relaxed);
+    size_t chunk = id >> CHUNK_BITS;
+    if (chunk >= MAX_CHUNKS) {
+        throw std::length_error("DocTable is full");
+    }
+    Article **slots = chunks[chunk].load(std::memory_order_relaxed);
+    if (slots == nullptr) {
+        slots = new Article *[CHUNK_SIZE]();
+        chunks[chunk].store(slots, std::memory_order_release);
+    }
+    slots[id & (CHUNK_SIZE - 1)] = article;
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+Index::Index(IndexConfig config) : config(config),
+                                   doc_store(config.store_path, config.store_block_bytes, config.store_cache_blocks),
+                                   current(std::make_shared<const IndexGeneration>(
+                                           IndexGeneration{0, {}, {}, &entity_dictionary})) {
+    if (config.background_merges) {
+        merger = std::thread(&Index::merge_loop, this);
+    }
+}
+
+Index::~Index() {
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        stopping = true;
+    }
+    merge_condition.notify_all();
+    if (merger.joinable()) {
+        merger.join();
+    }
+}
+
+DocId Index::add(Article *article) {
+    std::unique_ptr<Article> parsed(article);
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    DocId id = append(*parsed);
+    track(parsed->id, id);
+    total_tokens += parsed->tokens.size();
+    //The tokens now live in the buffer of its period; the article is not visible to readers until the next flush
+    SegmentBuilder &buffer = buffers.try_emplace(Metadata::partition(parsed->published, config.partitioning),
+                                                 config.positions).first->second;
+    buffer.add(id, *parsed, entity_dictionary.acquire(*parsed));
+    if (++buffered_docs >= config.max_buffered_docs) {
+        flush_locked();
+    }
+    return id;
+}
+
+bool Index::remove(const std::string &uuid) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    DocId id;
+    {
+        std::lock_guard<std::mutex> ids_lock(ids_mutex);
+        id = live_ids.erase(uuid);
+    }
+    if (id == UuidIndex::NONE) {
+        return false;
+    }
+    entity_dictionary.release(*doc_table.get(id));
+    pending_deletes.push_back(id);
+    return true;
+}
+
+DocId Index::append(const Article &article) {
+    //Copied rather than moved, so that none of the parsed article's allocations stay behind it in the heap
+    auto *resident = new Article();
+    resident->id = article.id;
+    resident->persons = article.persons;
+    resident->organizations = article.organizations;
+    DocId id = doc_table.append(resident);
+    doc_store.append(id, article);
+    return id;
+}
+
+void Index::track(const std::string &uuid, DocId id) {
+    DocId previous;
+    {
+        std::lock_guard<std::mutex> ids_lock(ids_mutex);
+        previous = live_ids.assign(uuid, id);
+    }
+    if (previous != UuidIndex::NONE) {
+        //Update: the new version replaces the old one at the same flush
+        entity_dictionary.release(*doc_table.get(previous));
+        pending_deletes.push_back(previous);
+    }
+}
+
+DocId Index::find(const std::string &uuid) const {
+    std::lock_guard<std::mutex> lock(ids_mutex);
+    return live_ids.find(uuid);
+}
+
+void Index::flush() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    flush_locked();
+}
+
+void Index::flush_locked() {
+    if (buffered_docs == 0 && pending_deletes.empty()) {
+        return;
+    }
+    std::vector<std::shared_ptr<const Segment>> sealed;
+    for (auto &[period, buffer]: buffers) {
+        if (buffer.doc_count() != 0) {
+            sealed.push_back(buffer.finish());
+        }
+    }
+    buffers.clear();
+    buffered_docs = 0;
+    publish([this, &sealed](IndexGeneration &generation) {
+        for (auto &segment: sealed) {
+            generation.segments.push_back(std::move(segment));
+            generation.deletions.emplace_back();
+        }
+        apply_deletes(generation, pending_deletes);
+    });
+    pending_deletes.clear();
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        merge_requested = true;
+    }
+    merge_condition.notify_all();
+}
+
+void Index::save(const std::filesystem::path &directory) const {
+    IndexSnapshot generation = snapshot();
+    //A single compacted segment, so file ordinals are its local ordinals
+    std::shared_ptr<const Segment> merged = Segment::merge(generation->segments, generation->deletions);
+    std::filesystem::create_directories(directory);
+
+    RecordWriter documents(directory / IndexFile::DOCUMENTS, IndexFile::DOCUMENTS_MAGIC);
+    UuidIndex uuids;
+    const std::vector<DocId> &docs = merged->doc_ids();
+    for (uint32_t ordinal = 0; ordinal < docs.size(); ++ordinal) {
+        Article article = doc_store.fetch(docs[ordinal]);
+        documents.put_article(article);
+        uuids.assign(article.id, ordinal);
+    }
+    documents.finish();
+    uuids.save(directory / IndexFile::UUIDS);
+
+    RecordWriter terms(directory / IndexFile::TERMS, IndexFile::TERMS_MAGIC, merged->has_positions());
+    merged->for_each_term([&terms, &merged](const std::string &term, uint32_t id) {
+        terms.put_term(term, {&merged->postings(id, Field::TEXT), &merged->postings(id, Field::TITLE)},
+                       &merged->positions(id));
+    });
+    terms.finish();
+}
+
+void Index::load(const std::filesystem::path &directory) {
+    RecordReader documents(directory / IndexFile::DOCUMENTS, IndexFile::DOCUMENTS_MAGIC);
+    RecordReader terms(directory / IndexFile::TERMS, IndexFile::TERMS_MAGIC);
+    //Its segment will be merged with the ones this index builds, which all have positions or all lack them
+    if (terms.positional() != config.positions) {
+        throw std::runtime_error(directory.string() + (terms.positional()
+                                 ? " has word positions; load it without --no-positions"
+                                 : " was saved without word positions; load it with --no-positions"));
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    //Buffered documents get older ids than the loaded ones
+    flush_locked();
+
+    //Into an empty index, the packed uuids come with their saved table instead of being hashed one by one
+    UuidIndex saved;
+    bool adopt = live_ids.size() == 0 && std::filesystem::exists(directory / IndexFile::UUIDS);
+    if (adopt) {
+        saved.load(directory / IndexFile::UUIDS);
+    }
+
+    //1- Documents: file ordinal i becomes local ordinal i of the new segment. Entity postings are rebuilt
+    //   from their tags (normalized again, for files saved before names were), metadata from the records
+    std::vector<DocId> docs;
+    docs.reserve(documents.size());
+    EntityPostings entities;
+    MetadataBuilder metadata;
+    Article article;
+    while (!documents.done()) {
+        documents.get_article(article);
+        for (std::string &name: article.persons) name = EntityDictionary::normalize(name);
+        for (std::string &name: article.organizations) name = EntityDictionary::normalize(name);
+        EntityIndex::add(entities, entity_dictionary.acquire(article), static_cast<uint32_t>(docs.size()));
+        metadata.add(article);
+        DocId id = append(article);
+        Uuid uuid;
+        if (!adopt || !UuidIndex::pack(article.id, uuid)) {
+            track(article.id, id);
+        }
+        docs.push_back(id);
+    }
+    if (adopt) {
+        std::lock_guard<std::mutex> ids_lock(ids_mutex);
+        live_ids.adopt(std::move(saved), docs);
+    }
+
+    //2- Terms are stored ascending, so the dictionaries are bulk-built
+    std::vector<std::string> sorted_terms(terms.size());
+    FieldPostings postings;
+    for (auto &field: postings) {
+        field.resize(terms.size());
+    }
+    std::vector<std::vector<uint8_t>> positions(terms.positional() ? terms.size() : 0);
+    std::array<std::vector<uint32_t>, FIELD_COUNT> record;
+    for (size_t i = 0; i < sorted_terms.size(); ++i) {
+        terms.get_term(sorted_terms[i], record, terms.positional() ? &positions[i] : nullptr);
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            postings[f][i].swap(record[f]);
+        }
+        total_tokens += postings[static_cast<size_t>(Field::TEXT)][i].size();
+    }
+    std::vector<std::shared_ptr<const Segment>> loaded{std::make_shared<const Segment>(
+            std::move(docs), std::move(sorted_terms), std::move(postings), std::move(positions),
+            terms.positional(), EntityIndex(std::move(entities)), metadata.finish())};
+
+    //3- A partitioned index splits it by publication period, periods in time order
+    if (config.partitioning != Partition::NONE) {
+        const Metadata &columns = loaded.front()->metadata();
+        std::map<int64_t, uint32_t> periods;
+        for (uint32_t local = 0; local < columns.size(); ++local) {
+            periods.emplace(Metadata::partition(columns.published_at(local), config.partitioning), 0);
+        }
+        if (periods.size() > 1) {
+            uint32_t part = 0;
+            for (auto &entry: periods) {
+                entry.second = part++;
+            }
+            std::vector<uint32_t> parts(columns.size());
+            for (uint32_t local = 0; local < columns.size(); ++local) {
+                parts[local] = periods[Metadata::partition(columns.published_at(local), config.partitioning)];
+            }
+            loaded = Segment::split(*loaded.front(), parts, periods.size());
+        }
+    }
+
+    //4- Publish it like a flushed segment
+    publish([this, &loaded](IndexGeneration &generation) {
+        for (auto &segment: loaded) {
+            if (segment == nullptr || segment->doc_count() == 0) continue;
+            generation.segments.push_back(std::move(segment));
+            generation.deletions.emplace_back();
+        }
+        apply_deletes(generation, pending_deletes);
+    });
+    pending_deletes.clear();
+    {
+        std::lock_guard<std::mutex> merge_lock(merge_mutex);
+        merge_requested = true;
+    }
+    merge_condition.notify_all();
+}
+
+template<typename F>
+void Index::publish(F &&update) {
+    std::lock_guard<std::mutex> lock(publish_mutex);
+    std::shared_ptr<const IndexGeneration> previous = current.current();
+    auto next = std::make_shared<IndexGeneration>(*previous);
+    next->number = previous->number + 1;
+    update(*next);
+    //Readers still on "previous" keep it; it is freed by a later reclaim() once they are done
+    current.publish(std::move(next));
+}
+
+void Index::apply_deletes(IndexGeneration &generation, const std::vector<DocId> &ids) {
+    //Bitmaps are shared with older generations, so each touched one is copied once
+    std::vector<std::shared_ptr<Bitmap>> copies(generation.segments.size());
+    for (DocId id: ids) {
+        for (size_t i = 0; i < generation.segments.size(); ++i) {
+            const std::vector<DocId> &docs = generation.segments[i]->doc_ids();
+            auto position = std::lower_bound(docs.cbegin(), docs.cend(), id);
+            if (position == docs.cend() || *position != id) {
+                continue;
+            }
+            if (copies[i] == nullptr) {
+                copies[i] = generation.deletions[i] == nullptr ? std::make_shared<Bitmap>(docs.size())
+                                                               : std::make_shared<Bitmap>(*generation.deletions[i]);
+                generation.deletions[i] = copies[i];
+            }
+            copies[i]->set(static_cast<size_t>(position - docs.cbegin()));
+            break;
+        }
+    }
+}
+
+int64_t Index::period_of(const Segment &segment) const {
+    Metadata::Zone bounds = segment.metadata().bounds(Column::PUBLISHED);
+    int64_t first = Metadata::partition(bounds.low, config.partitioning);
+    return first == Metadata::partition(bounds.high, config.partitioning) ? first : MIXED_PERIOD;
+}
+
+std::vector<size_t> Index::find_merge(const IndexGeneration &generation) const {
+    const auto &segments = generation.segments;
+    //Tier of a segment: how many times "merge_factor" fits between its size and a freshly flushed segment
+    auto tier = [this](const std::shared_ptr<const Segment> &segment) {
+        double ratio = static_cast<double>(segment->doc_count()) / static_cast<double>(config.max_buffered_docs);
+        if (ratio <= 1) return 0;
+        return static_cast<int>(std::log(ratio) / std::log(static_cast<double>(config.merge_factor)));
+    };
+    //Only segments of the same period are merged; without partitioning every segment is in period 0
+    std::map<int64_t, std::vector<size_t>> periods;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        periods[period_of(*segments[i])].push_back(i);
+    }
+    //Newest segments are at the back, so look for the smallest-tier window from there
+    for (const auto &[period, positions]: periods) {
+        if (config.merge_factor < 2 || positions.size() < config.merge_factor) {
+            continue;
+        }
+        for (size_t end = positions.size(); end >= config.merge_factor; --end) {
+            size_t begin = end - config.merge_factor;
+            int window_tier = tier(segments[positions[begin]]);
+            bool same_tier = true;
+            for (size_t i = begin + 1; i < end && same_tier; ++i) {
+                same_tier = tier(segments[positions[i]]) == window_tier;
+            }
+            if (same_tier) {
+                return {positions.cbegin() + static_cast<long>(begin), positions.cbegin() + static_cast<long>(end)};
+            }
+        }
+    }
+    //No merge due: compact the first segment carrying too many tombstones
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (generation.deletions[i] != nullptr &&
+            static_cast<double>(generation.deletions[i]->count()) >=
+            config.compact_deleted_ratio * static_cast<double>(segments[i]->doc_count())) {
+            return {i};
+        }
+    }
+    return {};
+}
+
+void Index::merge_loop() {
+    std::unique_lock<std::mutex> lock(merge_mutex);
+    for (;;) {
+        //While replaced generations are pending, wake up now and then to free them
+        while (!stopping && !merge_requested) {
+            if (current.has_retired()) {
+                merge_condition.wait_for(lock, std::chrono::milliseconds(50));
+                lock.unlock();
+                current.reclaim();
+                lock.lock();
+            } else {
+                merge_condition.wait(lock);
+            }
+        }
+        if (stopping) {
+            return;
+        }
+        merge_requested = false;
+        merging = true;
+        lock.unlock();
+
+        //Keep merging until the policy is satisfied; queries keep using whatever generation they hold
+        for (;;) {
+            std::shared_ptr<const IndexGeneration> base = current.current();
+            std::vector<size_t> chosen = find_merge(*base);
+            if (chosen.empty()) {
+                break;
+            }
+            std::vector<std::shared_ptr<const Segment>> sources;
+            std::vector<std::shared_ptr<const Bitmap>> source_deletions;
+            for (size_t position: chosen) {
+                sources.push_back(base->segments[position]);
+                source_deletions.push_back(base->deletions[position]);
+            }
+            std::shared_ptr<const Segment> merged = Segment::merge(sources, source_deletions);
+            publish([&sources, &source_deletions, &merged](IndexGeneration &generation) {
+                //Flushes only append and merges replace their sources in place, so the sources keep their order
+                std::vector<size_t> positions;
+                for (const auto &source: sources) {
+                    auto found = std::find(generation.segments.cbegin(), generation.segments.cend(), source);
+                    positions.push_back(static_cast<size_t>(found - generation.segments.cbegin()));
+                }
+                //Documents deleted while the merge ran are tombstoned in the merged segment
+                std::shared_ptr<Bitmap> carried;
+                const std::vector<DocId> &docs = merged->doc_ids();
+                for (size_t s = 0; s < sources.size(); ++s) {
+                    const auto &latest = generation.deletions[positions[s]];
+                    if (latest == source_deletions[s]) continue;
+                    latest->for_each([&](size_t local) {
+                        if (source_deletions[s] != nullptr && source_deletions[s]->test(local)) return;
+                        DocId id = sources[s]->global_id(static_cast<uint32_t>(local));
+                        auto position = std::lower_bound(docs.cbegin(), docs.cend(), id);
+                        if (carried == nullptr) carried = std::make_shared<Bitmap>(docs.size());
+                        carried->set(static_cast<size_t>(position - docs.cbegin()));
+                    });
+                }
+                for (size_t s = sources.size(); s-- > 0;) {
+                    generation.segments.erase(generation.segments.begin() + static_cast<long>(positions[s]));
+                    generation.deletions.erase(generation.deletions.begin() + static_cast<long>(positions[s]));
+                }
+                //The merged segment takes the place of the first source. One whose documents were all deleted
+                //simply goes away
+                if (merged->doc_count() != 0) {
+                    auto offset = static_cast<long>(positions.front());
+                    generation.segments.insert(generation.segments.begin() + offset, std::move(merged));
+                    generation.deletions.insert(generation.deletions.begin() + offset, std::move(carried));
+                }
+            });
+            std::lock_guard<std::mutex> stop_check(merge_mutex);
+            if (stopping) break;
+        }
+
+        lock.lock();
+        merging = false;
+        merge_condition.notify_all();
+    }
+}
+
+void Index::wait_for_merges() {
+    if (!config.background_merges) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(merge_mutex);
+    merge_condition.wait(lock, [this] { return stopping || (!merging && !merge_requested); });
+}
+
+std::vector<Pair> Index::term_statistics(const IndexGeneration &generation) {
+    std::map<std::string, unsigned int> frequencies;
+    for (const auto &segment: generation.segments) {
+        segment->for_each_term([&frequencies, &segment](const std::string &term, uint32_t id) {
+            size_t count = segment->postings(id, Field::TEXT).size();
+            if (count != 0) {
+                frequencies[term] += static_cast<unsigned int>(count);
+            }
+        });
+    }
+    std::vector<Pair> statistics;
+    statistics.reserve(frequencies.size());
+    for (auto &[term, frequency]: frequencies) {
+        std::string word = term;
+        statistics.emplace_back(word, frequency);
+    }
+    return statistics;
+}
+
+float Index::get_word_article_ratio() const {
+    DocId articles = doc_table.size();
+    return articles == 0 ? 0 : static_cast<float>(total_tokens.load()) / static_cast<float>(articles);
+}
@@ -0,0 +1,264 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Index.h
+ * @date:           10-19-2026
+ * @description:    Incremental, segment-based inverted index (LSM style).
+ *                      - New articles are indexed into an in-memory SegmentBuilder
+ *                      - A full buffer (or an explicit flush) is sealed into an immutable Segment
+ *                      - Readers take a snapshot (IndexGeneration) and fan out over its segments
+ *                      - A background thread merges runs of similar-sized segments (tiered policy)
+ *                        and publishes a new generation; readers of older generations are unaffected
+ *                      - Deleting an article (by uuid) sets its bit in its segment's tombstone bitmap;
+ *                        re-adding a uuid replaces the older article. Merges drop tombstoned documents,
+ *                        and a segment with too many of them is rewritten on its own (compaction)
+ *                      - With partitioning, documents are buffered and sealed per publication period (day,
+ *                        week or month), merges only combine segments of one period, and a loaded index is
+ *                        split by period, so each segment covers a single period and queries filtered by date
+ *                        skip the others
+ *                  Generations are published RCU-style (Rcu.h): taking a snapshot never locks, and a
+ *                  replaced generation is freed on a writer or merge thread once its last reader is done.
+ *                  Entity names are interned index-wide (EntityDictionary) as articles are added, and the
+ *                  live articles are found by uuid through a UuidIndex. Titles and texts go to a compressed
+ *                  DocStore on disk; only uuids and entity names stay in memory.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_INDEX_H
+#define INC_22S_FINAL_PROJ_INDEX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Article.h"
+#include "DocStore.h"
+#include "Pair.h"
+#include "Rcu.h"
+#include "Segment.h"
+#include "UuidIndex.h"
+
+struct IndexConfig {
+    /// \description Documents buffered in memory before they are sealed into a segment
+    size_t max_buffered_docs = 10000;
+    /// \description Number of same-tier segments merged together
+    size_t merge_factor = 10;
+    /// \description Run merges on a background thread; when false segments are never merged or compacted
+    bool background_merges = true;
+    /// \description Index word positions, needed by phrase and proximity queries
+    bool positions = true;
+    /// \description Fraction of deleted documents above which a segment is compacted
+    double compact_deleted_ratio = 0.2;
+    /// \description File the document store writes to. Empty means a temporary file, removed with the index
+    std::filesystem::path store_path;
+    /// \description Uncompressed bytes of articles per compressed block of the document store
+    size_t store_block_bytes = size_t(32) << 10;
+    /// \description Decompressed blocks of the document store kept in memory
+    size_t store_cache_blocks = 64;
+    /// \description Publication period each segment is restricted to. NONE lets a segment hold any date
+    Partition partitioning = Partition::NONE;
+};
+
+/// \description An immutable view of the index. Queries evaluate against one generation from start to end
+struct IndexGeneration {
+    uint64_t number = 0;
+    std::vector<std::shared_ptr<const Segment>> segments;
+    /// \description Tombstones of segments[i], by local ordinal. nullptr when nothing in it is deleted
+    std::vector<std::shared_ptr<const Bitmap>> deletions;
+    /// \description The index's entity dictionary. Ids interned after this generation are not in its segments
+    const EntityDictionary *entities = nullptr;
+
+    /// \return size_t      -> Number of searchable (not deleted) documents
+    size_t doc_count() const;
+
+    /// \param term         -> Stemmed term
+    /// \param field        -> Field to count in
+    /// \return size_t      -> Number of documents whose "field" contains "term", over all segments. Deleted
+    ///                     documents are counted until their segment is merged or compacted
+    size_t document_frequency(const std::string &term, Field field) const;
+
+    /// \return bool        -> Whether the document at "local" in segments[segment] is deleted
+    bool is_deleted(size_t segment, uint32_t local) const {
+        return deletions[segment] != nullptr && deletions[segment]->test(local);
+    }
+};
+
+/// \description A pinned generation. Hold it for the duration of a query; call retain() to keep the
+///              generation past that (it then lives until the last shared_ptr goes away)
+using IndexSnapshot = RcuCell<IndexGeneration>::ReadGuard;
+
+/// \description Stable, append-only DocId -> Article* table. Readers may look up any published id while
+///              the writer appends, because chunks are never moved once allocated. The Index keeps only the
+///              uuid and entity names of its articles here; their title and text are in its DocStore
+class DocTable {
+private:
+    static constexpr size_t CHUNK_BITS = 16;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t MAX_CHUNKS = size_t(1) << 16;
+
+    std::unique_ptr<std::atomic<Article **>[]> chunks;
+    std::atomic<DocId> count{0};
+
+public:
+    DocTable();
+
+    DocTable(const DocTable &) = delete;
+
+    DocTable &operator=(const DocTable &) = delete;
+
+    /// \description        -> Deletes every article
+    ~DocTable();
+
+    /// \param article      -> Article to store, ownership moves to the table
+    /// \return DocId       -> The article's id. Single writer only
+    DocId append(Article *article);
+
+    /// \return Article*    -> Article with the given id
+    Article *get(DocId id) const {
+        return chunks[id >> CHUNK_BITS].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+    }
+
+    DocId size() const { return count.load(std::memory_order_acquire); }
+};
+
+class Index {
+private:
+    static constexpr int64_t MIXED_PERIOD = INT64_MAX;
+
+    IndexConfig config;
+    DocTable doc_table;
+    DocStore doc_store;
+    EntityDictionary entity_dictionary;
+    std::atomic<uint64_t> total_tokens{0};
+
+    //Writer side: the buffers new documents go into (one per publication period), and deletes waiting for the
+    //next flush
+    std::mutex writer_mutex;
+    std::map<int64_t, SegmentBuilder> buffers;
+    size_t buffered_docs = 0;
+    std::vector<DocId> pending_deletes;
+
+    //uuid -> live article. Written under writer_mutex as well, so readers only wait for a single update
+    mutable std::mutex ids_mutex;
+    UuidIndex live_ids;
+
+    //Published state. Swapped whole, never modified in place; publish_mutex only orders the writers
+    std::mutex publish_mutex;
+    RcuCell<IndexGeneration> current;
+
+    //Background merging
+    std::mutex merge_mutex;
+    std::condition_variable merge_condition;
+    bool merge_requested = false;
+    bool merging = false;
+    bool stopping = false;
+    std::thread merger;
+
+    /// \description        -> Seals every buffer into a segment and publishes them. Caller holds writer_mutex
+    void flush_locked();
+
+    /// \param article      -> Parsed article
+    /// \return DocId       -> Id assigned to it. The article goes to the document store, and a copy of its uuid
+    ///                     and entity names to the doc table. Caller holds writer_mutex
+    DocId append(const Article &article);
+
+    /// \param uuid         -> uuid of an article just appended to the doc table
+    /// \param id           -> Its DocId
+    /// \description        -> Makes it the live article of "uuid"; an older one is deleted by the next flush.
+    ///                     Caller holds writer_mutex
+    void track(const std::string &uuid, DocId id);
+
+    /// \param update       -> Callable editing a copy of the current generation
+    /// \description        -> Publishes a new generation built from the current one
+    template<typename F>
+    void publish(F &&update);
+
+    /// \param segment      -> Segment to inspect
+    /// \return int64_t     -> Publication period (Metadata::partition) of all its documents, or MIXED_PERIOD when
+    ///                     they span several
+    int64_t period_of(const Segment &segment) const;
+
+    /// \param generation   -> Generation to inspect
+    /// \return vector      -> Ascending positions of the segments the tiered policy wants merged (a run of one
+    ///                     period's segments, in order), or of a single segment that needs compacting. Empty if
+    ///                     there is nothing to do
+    std::vector<size_t> find_merge(const IndexGeneration &generation) const;
+
+    /// \param generation   -> Generation to add the tombstones to
+    /// \param ids          -> Deleted documents
+    static void apply_deletes(IndexGeneration &generation, const std::vector<DocId> &ids);
+
+    /// \description        -> Body of the merge thread
+    void merge_loop();
+
+public:
+    explicit Index(IndexConfig config = {});
+
+    Index(const Index &) = delete;
+
+    Index &operator=(const Index &) = delete;
+
+    ~Index();
+
+    /// \param article      -> Parsed article, ownership moves to the index (which deletes it once stored)
+    /// \return DocId       -> Id assigned to the article. It becomes searchable after the next flush.
+    ///                     An older article with the same uuid is deleted by the same flush (update)
+    DocId add(Article *article);
+
+    /// \param uuid         -> uuid of the article to retract
+    /// \return bool        -> Whether a live article had that uuid. It disappears at the next flush
+    bool remove(const std::string &uuid);
+
+    /// \description        -> Makes every added article searchable and every removed one unsearchable
+    void flush();
+
+    /// \param directory    -> Index directory to write (see IndexFile.h)
+    /// \description        -> Saves the latest generation, with deleted documents left out
+    void save(const std::filesystem::path &directory) const;
+
+    /// \param directory    -> Index directory written by save() or by a SpimiBuilder
+    /// \description        -> Adds the saved documents to the index as one segment (one per publication period
+    ///                     when partitioned) and publishes it. A saved uuid that is already indexed replaces the
+    ///                     older article. A directory saved with word positions when this index is built without
+    ///                     them, or the other way around, throws std::runtime_error
+    void load(const std::filesystem::path &directory);
+
+    /// \return snapshot    -> The latest published generation, pinned. Lock-free, never waits for writers
+    IndexSnapshot snapshot() const { return current.read(); }
+
+    /// \return Article*    -> Article with the given id: its uuid and entity names. fetch() has the rest
+    const Article *article(DocId id) const { return doc_table.get(id); }
+
+    /// \return Article     -> Article with the given id as stored: uuid, title, text and entity names
+    Article fetch(DocId id) const { return doc_store.fetch(id); }
+
+    /// \param uuid         -> uuid of an article
+    /// \return DocId       -> Id of the live article with that uuid, or UuidIndex::NONE. Added articles are
+    ///                     found right away, before the flush that makes them searchable, and removed ones no
+    ///                     longer are
+    DocId find(const std::string &uuid) const;
+
+    /// \return DocStore    -> Where the articles' titles and texts are kept
+    const DocStore &documents() const { return doc_store; }
+
+    /// \return EntityDictionary -> Entities of the indexed articles, with their live document counts
+    const EntityDictionary &entities() const { return entity_dictionary; }
+
+    /// \description        -> Blocks until the merge policy has nothing left to do
+    void wait_for_merges();
+
+    /// \param generation   -> Generation to inspect
+    /// \return vector      -> (term, document frequency) for every distinct term, merged over all segments.
+    ///                     Deleted documents are counted until their segment is merged or compacted
+    static std::vector<Pair> term_statistics(const IndexGeneration &generation);
+
+    /// \return float       -> Average number of distinct indexed words per article
+    float get_word_article_ratio() const;
+};
+
+#endif //INC_22S_FINAL_PROJ_INDEX_H
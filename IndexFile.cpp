@@ -0,0 +1,168 @@
+#include "IndexFile.h"
+
+#include <stdexcept>
+
+RecordWriter::RecordWriter(const std::filesystem::path &path, uint32_t magic, bool positional)
+        : out(path, std::ios::binary | std::ios::trunc), flags(positional ? IndexFile::FLAG_POSITIONS : 0) {
+    if (!out) {
+        throw std::runtime_error("Cannot create " + path.string());
+    }
+    uint32_t version = IndexFile::VERSION;
+    out.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+    out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char *>(&flags), sizeof(flags));
+    out.write(reinterpret_cast<const char *>(&records), sizeof(records));
+}
+
+void RecordWriter::put_varint(uint64_t value) {
+    while (value >= 0x80) {
+        out.put(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.put(static_cast<char>(value));
+}
+
+void RecordWriter::put_string(const std::string &value) {
+    put_varint(value.size());
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+void RecordWriter::put_article(const Article &article) {
+    put_string(article.id);
+    put_string(article.title);
+    put_string(article.text);
+    put_varint(article.persons.size());
+    for (const std::string &person: article.persons) put_string(person);
+    put_varint(article.organizations.size());
+    for (const std::string &organization: article.organizations) put_string(organization);
+    out.write(reinterpret_cast<const char *>(&article.published), sizeof(article.published));
+    put_string(article.site);
+    put_string(article.language);
+    ++records;
+}
+
+void RecordWriter::put_postings(const std::vector<uint32_t> &postings) {
+    put_varint(postings.size());
+    uint32_t previous = 0;
+    for (uint32_t ordinal: postings) {
+        put_varint(ordinal - previous);
+        previous = ordinal;
+    }
+}
+
+void RecordWriter::put_term(const std::string &term,
+                            const std::array<const std::vector<uint32_t> *, FIELD_COUNT> &postings,
+                            const std::vector<uint8_t> *positions) {
+    static const std::vector<uint32_t> none;
+    put_string(term);
+    for (const std::vector<uint32_t> *field: postings) {
+        put_postings(field == nullptr ? none : *field);
+    }
+    if (flags & IndexFile::FLAG_POSITIONS) {
+        size_t length = positions == nullptr ? 0 : positions->size();
+        put_varint(length);
+        if (length != 0) {
+            out.write(reinterpret_cast<const char *>(positions->data()), static_cast<std::streamsize>(length));
+        }
+    }
+    ++records;
+}
+
+void RecordWriter::put_block(const void *data, size_t size, uint64_t count) {
+    out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    records += count;
+}
+
+void RecordWriter::finish() {
+    //The count sits right after magic, version and flags
+    out.seekp(3 * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(&records), sizeof(records));
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error("Failed writing index file");
+    }
+}
+
+RecordReader::RecordReader(const std::filesystem::path &path, uint32_t magic) : in(path, std::ios::binary) {
+    uint32_t file_magic = 0;
+    in.read(reinterpret_cast<char *>(&file_magic), sizeof(file_magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    in.read(reinterpret_cast<char *>(&flags), sizeof(flags));
+    in.read(reinterpret_cast<char *>(&records), sizeof(records));
+    if (!in || file_magic != magic || version != IndexFile::VERSION) {
+        throw std::runtime_error("Not a valid index file: " + path.string());
+    }
+}
+
+uint64_t RecordReader::get_varint() {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof() || shift > 63) {
+            throw std::runtime_error("Truncated index file");
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+}
+
+void RecordReader::get_string(std::string &value) {
+    value.resize(get_varint());
+    in.read(value.data(), static_cast<std::streamsize>(value.size()));
+    if (!in) {
+        throw std::runtime_error("Truncated index file");
+    }
+}
+
+void RecordReader::get_article(Article &article) {
+    get_string(article.id);
+    get_string(article.title);
+    get_string(article.text);
+    article.persons.resize(get_varint());
+    for (std::string &person: article.persons) get_string(person);
+    article.organizations.resize(get_varint());
+    for (std::string &organization: article.organizations) get_string(organization);
+    in.read(reinterpret_cast<char *>(&article.published), sizeof(article.published));
+    get_string(article.site);
+    get_string(article.language);
+    ++consumed;
+}
+
+void RecordReader::get_postings(std::vector<uint32_t> &postings) {
+    postings.resize(get_varint());
+    uint32_t previous = 0;
+    for (uint32_t &ordinal: postings) {
+        ordinal = previous + static_cast<uint32_t>(get_varint());
+        previous = ordinal;
+    }
+}
+
+void RecordReader::get_term(std::string &term, std::array<std::vector<uint32_t>, FIELD_COUNT> &postings,
+                            std::vector<uint8_t> *positions) {
+    get_string(term);
+    //Fields appear in Field order
+    for (std::vector<uint32_t> &field: postings) {
+        get_postings(field);
+    }
+    if (positional()) {
+        size_t length = get_varint();
+        if (positions != nullptr) {
+            positions->resize(length);
+            in.read(reinterpret_cast<char *>(positions->data()), static_cast<std::streamsize>(length));
+        } else {
+            in.ignore(static_cast<std::streamsize>(length));
+        }
+        if (!in) {
+            throw std::runtime_error("Truncated index file");
+        }
+    }
+    ++consumed;
+}
+
+void RecordReader::get_block(void *data, size_t size, uint64_t count) {
+    in.read(static_cast<char *>(data), static_cast<std::streamsize>(size));
+    if (!in) {
+        throw std::runtime_error("Truncated index file");
+    }
+    consumed += count;
+}
@@ -0,0 +1,125 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       IndexFile.h
+ * @date:           10-19-2026
+ * @description:    On-disk format of a saved index. An index directory holds two record files:
+ *                      - documents.dat: one record per document (uuid, title, text, persons, organizations,
+ *                        publication time as 8 bytes, site, language), in ordinal order
+ *                      - terms.dat: one record per term, ascending: the term, then for each Field the
+ *                        ascending ordinals of the documents whose field contains it (delta + varint
+ *                        encoded), then, in positional files, the term's text Positions blob
+ *                      - uuids.dat (optional): the UuidIndex of the documents, its slots as they are in memory,
+ *                        mapping each uuid to its ordinal in documents.dat. Without it the uuids are rehashed
+ *                  Every file starts with a header (magic, version, flags, record count). There is a single
+ *                  format version: a file of any other version is rejected. The spilled runs of an external
+ *                  build use the terms format too.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_INDEXFILE_H
+#define INC_22S_FINAL_PROJ_INDEXFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Article.h"
+
+class IndexFile {
+public:
+    static constexpr uint32_t DOCUMENTS_MAGIC = 0x43445947; //"GYDC"
+    static constexpr uint32_t TERMS_MAGIC = 0x4d545947;     //"GYTM"
+    static constexpr uint32_t RUN_MAGIC = 0x4e525947;       //"GYRN"
+    static constexpr uint32_t UUIDS_MAGIC = 0x44495947;     //"GYID"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_POSITIONS = 1;
+
+    static constexpr const char *DOCUMENTS = "documents.dat";
+    static constexpr const char *TERMS = "terms.dat";
+    static constexpr const char *UUIDS = "uuids.dat";
+};
+
+class RecordWriter {
+private:
+    std::ofstream out;
+    uint32_t flags;
+    uint64_t records = 0;
+
+    void put_varint(uint64_t value);
+
+    void put_string(const std::string &value);
+
+    void put_postings(const std::vector<uint32_t> &postings);
+
+public:
+    /// \param path         -> File to create (truncated if it exists)
+    /// \param magic        -> One of the IndexFile magics
+    /// \param positional   -> Whether term records carry positions
+    RecordWriter(const std::filesystem::path &path, uint32_t magic, bool positional = false);
+
+    /// \param article      -> Document record
+    void put_article(const Article &article);
+
+    /// \param term         -> Term record key, greater than the previous one
+    /// \param postings     -> Ascending ordinals, per field
+    /// \param positions    -> Text positions blob of the term; only written by a positional writer
+    void put_term(const std::string &term, const std::array<const std::vector<uint32_t> *, FIELD_COUNT> &postings,
+                  const std::vector<uint8_t> *positions = nullptr);
+
+    /// \param data         -> Fixed-size records, written as they are in memory
+    /// \param size         -> Number of bytes
+    /// \param count        -> Number of records they hold
+    void put_block(const void *data, size_t size, uint64_t count);
+
+    /// \return uint64_t    -> Records written so far
+    uint64_t size() const { return records; }
+
+    /// \description        -> Writes the record count into the header and closes the file
+    void finish();
+};
+
+class RecordReader {
+private:
+    std::ifstream in;
+    uint32_t version = 0;
+    uint32_t flags = 0;
+    uint64_t records = 0;
+    uint64_t consumed = 0;
+
+    uint64_t get_varint();
+
+    void get_string(std::string &value);
+
+    void get_postings(std::vector<uint32_t> &postings);
+
+public:
+    /// \param path         -> File to read
+    /// \param magic        -> Expected magic; a mismatch, another version or a missing file throws
+    RecordReader(const std::filesystem::path &path, uint32_t magic);
+
+    /// \return uint64_t    -> Number of records in the file
+    uint64_t size() const { return records; }
+
+    /// \return bool        -> Whether term records carry positions
+    bool positional() const { return flags & IndexFile::FLAG_POSITIONS; }
+
+    /// \return bool        -> Whether every record has been read
+    bool done() const { return consumed == records; }
+
+    /// \param article      -> Receives the next document record
+    void get_article(Article &article);
+
+    /// \param term         -> Receives the next term
+    /// \param postings     -> Receives its ordinals per field (replacing the previous contents)
+    /// \param positions    -> Receives its Positions blob, if the file has them and this is not nullptr
+    void get_term(std::string &term, std::array<std::vector<uint32_t>, FIELD_COUNT> &postings,
+                  std::vector<uint8_t> *positions = nullptr);
+
+    /// \param data         -> Receives the next "size" bytes: fixed-size records written by put_block
+    /// \param count        -> Number of records they hold
+    void get_block(void *data, size_t size, uint64_t count);
+};
+
+#endif //INC_22S_FINAL_PROJ_INDEXFILE_H
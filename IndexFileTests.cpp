@@ -0,0 +1,86 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       IndexFileTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the index record files: document and term records read back as written, and files
+ *                  of another format version or magic are rejected.
+ */
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "IndexFile.h"
+
+TEST_CASE("IndexFile records round trip", "[IndexFile]") {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "googleyes-indexfile-test.dat";
+    Article written;
+    written.id = "a1";
+    written.title = "Rates";
+    written.text = "interest rate hike";
+    written.persons = {"jerome powell"};
+    written.published = 1520157600;
+    written.site = "reuters.com";
+    written.language = "english";
+    {
+        RecordWriter writer(path, IndexFile::DOCUMENTS_MAGIC);
+        writer.put_article(written);
+        writer.finish();
+    }
+
+    SECTION("a document record comes back whole") {
+        RecordReader reader(path, IndexFile::DOCUMENTS_MAGIC);
+        REQUIRE(reader.size() == 1);
+        Article read;
+        reader.get_article(read);
+        CHECK(reader.done());
+        CHECK(read.id == written.id);
+        CHECK(read.text == written.text);
+        CHECK(read.persons == written.persons);
+        CHECK(read.organizations.empty());
+        CHECK(read.published == written.published);
+        CHECK(read.site == written.site);
+        CHECK(read.language == written.language);
+    }
+
+    SECTION("another magic is rejected") {
+        CHECK_THROWS_AS(RecordReader(path, IndexFile::TERMS_MAGIC), std::runtime_error);
+    }
+
+    SECTION("another format version is rejected") {
+        //The version follows the magic
+        for (uint32_t version: {IndexFile::VERSION - 1, IndexFile::VERSION + 1}) {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(sizeof(uint32_t));
+            file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+            file.close();
+            CHECK_THROWS_AS(RecordReader(path, IndexFile::DOCUMENTS_MAGIC), std::runtime_error);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("IndexFile term records keep every field and the positions", "[IndexFile]") {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "googleyes-indexfile-terms.dat";
+    std::vector<uint32_t> text{1, 5, 300}, title{5};
+    std::vector<uint8_t> blob{3, 1, 4, 1, 5};
+    {
+        RecordWriter writer(path, IndexFile::TERMS_MAGIC, true);
+        writer.put_term("rate", {&text, &title}, &blob);
+        writer.finish();
+    }
+    RecordReader reader(path, IndexFile::TERMS_MAGIC);
+    CHECK(reader.positional());
+    std::string term;
+    std::array<std::vector<uint32_t>, FIELD_COUNT> postings;
+    std::vector<uint8_t> positions;
+    reader.get_term(term, postings, &positions);
+    CHECK(term == "rate");
+    CHECK(postings[static_cast<size_t>(Field::TEXT)] == text);
+    CHECK(postings[static_cast<size_t>(Field::TITLE)] == title);
+    CHECK(positions == blob);
+    CHECK(reader.done());
+    std::filesystem::remove(path);
+}
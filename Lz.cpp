@@ -0,0 +1,137 @@
+#include "Lz.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 14;
+
+/// \return uint32_t    -> Hash-table slot of the 4 bytes at "data"
+static uint32_t slot_of(const uint8_t *data) {
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return (word * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/// \description        -> Writes the part of a length above 15 (the token holds the 15)
+static void put_length(std::vector<uint8_t> &out, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+/// \description        -> Appends one sequence: the literals, then the match if "match_length" is not 0
+static void put_sequence(std::vector<uint8_t> &out, const uint8_t *literals, size_t literal_length,
+                         size_t offset, size_t match_length) {
+    size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    size_t token = std::min<size_t>(literal_length, 15) << 4 | std::min<size_t>(match_code, 15);
+    out.push_back(static_cast<uint8_t>(token));
+    if (literal_length >= 15) {
+        put_length(out, literal_length);
+    }
+    out.insert(out.end(), literals, literals + literal_length);
+    if (match_length == 0) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 15) {
+        put_length(out, match_code);
+    }
+}
+
+void Lz::compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out) {
+    out.clear();
+    out.reserve(size / 2 + 16);
+    //Position + 1 of the last 4-byte string with each hash; 0 is an empty slot
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + MIN_MATCH <= size) {
+        uint32_t slot = slot_of(data + i);
+        size_t candidate = table[slot];
+        table[slot] = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET ||
+            std::memcmp(data + candidate - 1, data + i, MIN_MATCH) != 0) {
+            ++i;
+            continue;
+        }
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (i + length < size && data[match + length] == data[i + length]) {
+            ++length;
+        }
+        put_sequence(out, data + anchor, i - anchor, i - match, length);
+        i += length;
+        anchor = i;
+    }
+    put_sequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+void Lz::decompress(const uint8_t *data, size_t size, size_t raw_size, std::vector<uint8_t> &out) {
+    out.resize(raw_size);
+    uint8_t *written = out.data();
+    uint8_t *out_end = out.data() + raw_size;
+    const uint8_t *end = data + size;
+    auto corrupt = []() { throw std::runtime_error("Corrupt compressed block"); };
+    //Reads the extension of a length whose nibble was 15
+    auto get_length = [&data, end, &corrupt](size_t length) {
+        uint8_t byte;
+        do {
+            if (data == end) corrupt();
+            byte = *data++;
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+    while (data < end) {
+        uint8_t token = *data++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            literal_length = get_length(literal_length);
+        }
+        if (static_cast<size_t>(end - data) < literal_length ||
+            static_cast<size_t>(out_end - written) < literal_length) {
+            corrupt();
+        }
+        //An empty block decodes into an empty (possibly null) buffer, which memcpy must not be given
+        if (literal_length != 0) {
+            std::memcpy(written, data, literal_length);
+        }
+        written += literal_length;
+        data += literal_length;
+        if (data == end) {
+            break;
+        }
+        if (end - data < 2) {
+            corrupt();
+        }
+        size_t offset = data[0] | static_cast<size_t>(data[1]) << 8;
+        data += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15) {
+            match_length = get_length(match_length);
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(written - out.data()) ||
+            static_cast<size_t>(out_end - written) < match_length) {
+            corrupt();
+        }
+        const uint8_t *from = written - offset;
+        if (offset >= match_length) {
+            std::memcpy(written, from, match_length);
+            written += match_length;
+        } else {
+            //The match overlaps the bytes it produces (a run): byte by byte
+            for (size_t k = 0; k < match_length; ++k) {
+                *written++ = from[k];
+            }
+        }
+    }
+    if (written != out_end) {
+        corrupt();
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Lz.h
+ * @date:           10-19-2026
+ * @description:    Small LZ77 codec for the document store, in the spirit of LZ4: fast to decompress, greedy
+ *                  to compress. The compressed stream is a list of sequences:
+ *                      token(literal length:4 | match length - 4:4) [literal length extension]
+ *                      literals offset(2 bytes, little endian) [match length extension]
+ *                  A nibble of 15 is extended by bytes added to it, each 255 meaning another byte follows.
+ *                  The last sequence is literals only. Matches are found through a hash table of the
+ *                  4-byte strings seen so far and reach back at most 64 KB.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_LZ_H
+#define INC_22S_FINAL_PROJ_LZ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Lz {
+public:
+    /// \param data         -> Bytes to compress
+    /// \param size         -> Number of bytes
+    /// \param out          -> Receives the compressed stream (replacing its contents)
+    static void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+    /// \param data         -> Compressed stream
+    /// \param size         -> Its length
+    /// \param raw_size     -> Length of the original bytes
+    /// \param out          -> Receives them (replacing its contents). A stream that does not decode to exactly
+    ///                     "raw_size" bytes throws
+    static void decompress(const uint8_t *data, size_t size, size_t raw_size, std::vector<uint8_t> &out);
+};
+
+#endif //INC_22S_FINAL_PROJ_LZ_H
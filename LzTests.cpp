@@ -0,0 +1,127 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       LzTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the document store's codec: compress -> decompress round trips over the edge cases
+ *                  of the stream format (empty and tiny inputs, length extensions, overlapping matches), and
+ *                  streams that must be rejected as corrupt.
+ */
+
+#include "catch.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Lz.h"
+
+/// \param raw          -> Bytes to compress
+/// \return vector      -> What decompressing their compressed stream gives back
+static std::vector<uint8_t> round_trip(const std::vector<uint8_t> &raw) {
+    std::vector<uint8_t> compressed, out;
+    Lz::compress(raw.data(), raw.size(), compressed);
+    Lz::decompress(compressed.data(), compressed.size(), raw.size(), out);
+    return out;
+}
+
+/// \param size         -> Number of bytes
+/// \return vector      -> Random bytes, which leave nothing to match: one literal run
+static std::vector<uint8_t> random_bytes(size_t size) {
+    std::mt19937 random(static_cast<uint32_t>(size));
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t &byte: bytes) byte = static_cast<uint8_t>(random());
+    return bytes;
+}
+
+TEST_CASE("Lz round trips", "[Lz]") {
+    SECTION("empty input") {
+        std::vector<uint8_t> compressed;
+        Lz::compress(nullptr, 0, compressed);
+        CHECK(compressed.size() == 1);
+        CHECK(round_trip({}).empty());
+    }
+
+    SECTION("inputs shorter than a match") {
+        for (size_t size = 1; size < 4; ++size) {
+            std::vector<uint8_t> raw(size, 'a');
+            CHECK(round_trip(raw) == raw);
+        }
+        std::vector<uint8_t> raw{'x', 'y', 'z'};
+        CHECK(round_trip(raw) == raw);
+    }
+
+    SECTION("literal runs around the length extensions") {
+        //14 fits the token; 15 needs an extension byte of 0; 15 + 255 needs a byte of 255 and another one
+        for (size_t size: {14, 15, 16, 15 + 254, 15 + 255, 15 + 256, 15 + 2 * 255, 5000}) {
+            std::vector<uint8_t> raw = random_bytes(size);
+            CHECK(round_trip(raw) == raw);
+        }
+    }
+
+    SECTION("matches that overlap the bytes they produce") {
+        //Offset 1 (one repeated byte) and offset 3, long enough for several extension bytes
+        std::vector<uint8_t> run(4000, 'a');
+        CHECK(round_trip(run) == run);
+        std::string pattern;
+        while (pattern.size() < 1000) pattern += "abc";
+        std::vector<uint8_t> repeated(pattern.cbegin(), pattern.cend());
+        CHECK(round_trip(repeated) == repeated);
+        std::vector<uint8_t> compressed;
+        Lz::compress(run.data(), run.size(), compressed);
+        CHECK(compressed.size() < 32);
+    }
+
+    SECTION("matches after a long literal run, and matches reaching back past 64 KB") {
+        std::vector<uint8_t> raw = random_bytes(300);
+        std::vector<uint8_t> far = random_bytes(70000);
+        raw.insert(raw.end(), raw.cbegin(), raw.cbegin() + 300);
+        raw.insert(raw.end(), far.cbegin(), far.cend());
+        raw.insert(raw.end(), raw.cbegin(), raw.cbegin() + 600);
+        CHECK(round_trip(raw) == raw);
+    }
+
+    SECTION("mixed text") {
+        std::mt19937 random(11);
+        const char *words[] = {"market ", "apple ", "shares ", "rose ", "in ", "the ", "\n"};
+        std::string text;
+        while (text.size() < 20000) text += words[random() % 7];
+        std::vector<uint8_t> raw(text.cbegin(), text.cend());
+        CHECK(round_trip(raw) == raw);
+    }
+}
+
+TEST_CASE("Lz rejects corrupt streams", "[Lz]") {
+    std::string text = "the quick brown fox jumps over the lazy dog, the quick brown fox jumps again";
+    std::vector<uint8_t> raw(text.cbegin(), text.cend());
+    std::vector<uint8_t> compressed, out;
+    Lz::compress(raw.data(), raw.size(), compressed);
+    REQUIRE(compressed.size() < raw.size());
+
+    SECTION("a truncated stream") {
+        compressed.pop_back();
+        CHECK_THROWS_AS(Lz::decompress(compressed.data(), compressed.size(), raw.size(), out), std::runtime_error);
+    }
+
+    SECTION("a raw size that does not match") {
+        CHECK_THROWS_AS(Lz::decompress(compressed.data(), compressed.size(), raw.size() + 1, out),
+                        std::runtime_error);
+        CHECK_THROWS_AS(Lz::decompress(compressed.data(), compressed.size(), raw.size() - 1, out),
+                        std::runtime_error);
+    }
+
+    SECTION("a match reaching before the first byte") {
+        //No literals, then a match at offset 5 with nothing written yet
+        std::vector<uint8_t> bad{0x00, 0x05, 0x00};
+        CHECK_THROWS_AS(Lz::decompress(bad.data(), bad.size(), 4, out), std::runtime_error);
+    }
+
+    SECTION("a match of offset 0") {
+        std::vector<uint8_t> bad{0x10, 'a', 0x00, 0x00};
+        CHECK_THROWS_AS(Lz::decompress(bad.data(), bad.size(), 5, out), std::runtime_error);
+    }
+
+    SECTION("a length extension cut short") {
+        std::vector<uint8_t> bad{0xf0, 255};
+        CHECK_THROWS_AS(Lz::decompress(bad.data(), bad.size(), 300, out), std::runtime_error);
+    }
+}
@@ -0,0 +1,326 @@
+#include "Metadata.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+static constexpr int64_t SECONDS_PER_DAY = 86400;
+
+/// \return int64_t     -> Days from 1970-01-01 to the given date of the proleptic Gregorian calendar
+static int64_t days_from_civil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+/// \param year         -> Year of the proleptic Gregorian calendar
+/// \param month        -> Month of that year (1 to 12)
+/// \return int64_t     -> Number of days in that month, 29 for February of a leap year
+static int64_t days_in_month(int64_t year, int64_t month) {
+    static constexpr int64_t DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : DAYS[month - 1];
+}
+
+/// \param days         -> Days since 1970-01-01
+/// \param year         -> Receives the year of that day
+/// \param month        -> Receives its month (1 to 12)
+/// \param day          -> Receives its day of the month (1 to 31)
+static void civil_from_days(int64_t days, int64_t &year, int64_t &month, int64_t &day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t day_of_era = days - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t shifted_month = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    year = year_of_era + era * 400 + (month <= 2);
+}
+
+/// \param text         -> Text being parsed
+/// \param at           -> Position to read from; moved past the digits
+/// \param digits       -> Exact number of digits to read
+/// \param value        -> Receives their value
+/// \return bool        -> Whether "digits" digits were there
+static bool read_number(const std::string &text, size_t &at, size_t digits, int64_t &value) {
+    if (at + digits > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t end = at + digits; at < end; ++at) {
+        if (!std::isdigit(static_cast<unsigned char>(text[at]))) {
+            return false;
+        }
+        value = value * 10 + (text[at] - '0');
+    }
+    return true;
+}
+
+/// \param text         -> "YYYY", "YYYY-MM" or "YYYY-MM-DD"
+/// \param start        -> Receives the first second of the period
+/// \param end          -> Receives the first second after it
+/// \return bool        -> Whether "text" is such a period
+static bool parse_period(const std::string &text, int64_t &start, int64_t &end) {
+    size_t at = 0;
+    int64_t year, month = 1, day = 1;
+    if (!read_number(text, at, 4, year)) {
+        return false;
+    }
+    //Each part given narrows the period to it
+    int64_t next_year = year + 1, next_month = 1, next_day = 1;
+    if (at < text.size()) {
+        if (text[at++] != '-' || !read_number(text, at, 2, month) || month < 1 || month > 12) {
+            return false;
+        }
+        next_year = month == 12 ? year + 1 : year;
+        next_month = month == 12 ? 1 : month + 1;
+    }
+    if (at < text.size()) {
+        if (text[at++] != '-' || !read_number(text, at, 2, day) || day < 1 ||
+            day > days_in_month(year, month) || at != text.size()) {
+            return false;
+        }
+        next_year = year;
+        next_month = month;
+        next_day = day + 1;
+    }
+    start = days_from_civil(year, month, day) * SECONDS_PER_DAY;
+    end = days_from_civil(next_year, next_month, next_day) * SECONDS_PER_DAY;
+    return true;
+}
+
+/// \param values       -> One value per ordinal
+/// \param zones        -> Receives the smallest and largest value of every ZONE_SIZE ordinals
+template<typename T>
+static void build_zones(const std::vector<T> &values, std::vector<Metadata::Zone> &zones) {
+    zones.clear();
+    for (size_t first = 0; first < values.size(); first += Metadata::ZONE_SIZE) {
+        auto [low, high] = std::minmax_element(values.cbegin() + static_cast<long>(first),
+                                               values.cbegin() + static_cast<long>(
+                                                       std::min(first + Metadata::ZONE_SIZE, values.size())));
+        zones.push_back({static_cast<int64_t>(*low), static_cast<int64_t>(*high)});
+    }
+}
+
+/// \param values       -> One value per ordinal
+/// \param zones        -> Their zone map
+/// \param low          -> Smallest value to keep
+/// \param high         -> Largest value to keep
+/// \param selected     -> Receives the ordinals whose value lies in [low, high]
+template<typename T>
+static void scan(const std::vector<T> &values, const std::vector<Metadata::Zone> &zones, int64_t low, int64_t high,
+                 Bitmap &selected) {
+    for (size_t z = 0; z < zones.size(); ++z) {
+        if (zones[z].high < low || zones[z].low > high) {
+            continue;
+        }
+        bool whole = zones[z].low >= low && zones[z].high <= high;
+        size_t last = std::min((z + 1) * Metadata::ZONE_SIZE, values.size());
+        //Zones start on word boundaries, so every word of the zone is built in a register and stored once
+        for (size_t first = z * Metadata::ZONE_SIZE; first < last; first += 64) {
+            size_t count = std::min<size_t>(64, last - first);
+            uint64_t word = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+            if (!whole) {
+                word = 0;
+                const T *run = values.data() + first;
+                for (size_t i = 0; i < count; ++i) {
+                    auto value = static_cast<int64_t>(run[i]);
+                    word |= static_cast<uint64_t>(value >= low && value <= high) << i;
+                }
+            }
+            selected.set_word(first / 64, word);
+        }
+    }
+}
+
+Metadata::Metadata(std::vector<int64_t> &&published,
+                   std::array<std::vector<std::string>, DICTIONARY_COLUMN_COUNT> &&dictionaries,
+                   std::array<std::vector<uint32_t>, DICTIONARY_COLUMN_COUNT> &&codes)
+        : published(std::move(published)), dictionaries(std::move(dictionaries)), codes(std::move(codes)) {
+    build_zones(this->published, zones[static_cast<size_t>(Column::PUBLISHED)]);
+    for (size_t c = 0; c < DICTIONARY_COLUMN_COUNT; ++c) {
+        build_zones(this->codes[c], zones[c + 1]);
+    }
+}
+
+std::pair<int64_t, int64_t> Metadata::code_range(Column column, const std::string &value, bool prefix) const {
+    const std::vector<std::string> &values = dictionaries[dictionary(column)];
+    auto first = std::lower_bound(values.cbegin(), values.cend(), value);
+    auto last = first;
+    if (prefix) {
+        last = std::partition_point(first, values.cend(), [&value](const std::string &candidate) {
+            return candidate.compare(0, value.size(), value) == 0;
+        });
+    } else if (last != values.cend() && *last == value) {
+        ++last;
+    }
+    return {first - values.cbegin(), (last - values.cbegin()) - 1};
+}
+
+Metadata::Zone Metadata::bounds(Column column) const {
+    Zone all{std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()};
+    for (const Zone &zone: zones[static_cast<size_t>(column)]) {
+        all.low = std::min(all.low, zone.low);
+        all.high = std::max(all.high, zone.high);
+    }
+    return all;
+}
+
+Bitmap Metadata::select(Column column, int64_t low, int64_t high) const {
+    Bitmap selected(size());
+    if (low > high) {
+        return selected;
+    }
+    const std::vector<Zone> &column_zones = zones[static_cast<size_t>(column)];
+    if (column == Column::PUBLISHED) {
+        scan(published, column_zones, low, high, selected);
+    } else {
+        scan(codes[dictionary(column)], column_zones, low, high, selected);
+    }
+    return selected;
+}
+
+bool Metadata::parse_time(const std::string &text, int64_t &seconds) {
+    //1- The date
+    size_t at = 0;
+    int64_t year, month, day, hour = 0, minute = 0, second = 0;
+    if (!read_number(text, at, 4, year) || at == text.size() || text[at++] != '-' ||
+        !read_number(text, at, 2, month) || at == text.size() || text[at++] != '-' ||
+        !read_number(text, at, 2, day) || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) {
+        return false;
+    }
+    //2- The time of day, seconds and fraction optional
+    if (at < text.size() && (text[at] == 'T' || text[at] == ' ')) {
+        ++at;
+        if (!read_number(text, at, 2, hour) || at == text.size() || text[at++] != ':' ||
+            !read_number(text, at, 2, minute)) {
+            return false;
+        }
+        if (at < text.size() && text[at] == ':') {
+            ++at;
+            if (!read_number(text, at, 2, second)) {
+                return false;
+            }
+            if (at < text.size() && text[at] == '.') {
+                ++at;
+                while (at < text.size() && std::isdigit(static_cast<unsigned char>(text[at]))) ++at;
+            }
+        }
+    }
+    //3- The zone: times are stored in UTC
+    int64_t offset = 0;
+    if (at < text.size() && text[at] == 'Z') {
+        ++at;
+    } else if (at < text.size() && (text[at] == '+' || text[at] == '-')) {
+        int64_t sign = text[at++] == '-' ? -1 : 1;
+        int64_t offset_hours, offset_minutes = 0;
+        if (!read_number(text, at, 2, offset_hours)) {
+            return false;
+        }
+        if (at < text.size() && text[at] == ':') ++at;
+        if (at < text.size() && !read_number(text, at, 2, offset_minutes)) {
+            return false;
+        }
+        offset = sign * (offset_hours * 3600 + offset_minutes * 60);
+    }
+    if (at != text.size()) {
+        return false;
+    }
+    seconds = days_from_civil(year, month, day) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second - offset;
+    return true;
+}
+
+bool Metadata::parse_date_range(const std::string &text, int64_t &low, int64_t &high) {
+    int64_t start, end;
+    size_t dots = text.find("..");
+    if (dots == std::string::npos) {
+        if (!parse_period(text, start, end)) {
+            return false;
+        }
+        low = start;
+        high = end - 1;
+        return true;
+    }
+    //Open sides reach as far as times go, but not to the documents without a date
+    std::string from = text.substr(0, dots), to = text.substr(dots + 2);
+    low = UNKNOWN_DATE + 1;
+    high = std::numeric_limits<int64_t>::max();
+    if (!from.empty()) {
+        if (!parse_period(from, start, end)) return false;
+        low = start;
+    }
+    if (!to.empty()) {
+        if (!parse_period(to, start, end)) return false;
+        high = end - 1;
+    }
+    return !(from.empty() && to.empty());
+}
+
+std::string Metadata::format_date(int64_t seconds) {
+    int64_t days = seconds / SECONDS_PER_DAY - (seconds % SECONDS_PER_DAY < 0);
+    int64_t year, month, day;
+    civil_from_days(days, year, month, day);
+    std::string date = std::to_string(year) + (month < 10 ? "-0" : "-") + std::to_string(month) +
+                       (day < 10 ? "-0" : "-") + std::to_string(day);
+    return date;
+}
+
+int64_t Metadata::partition(int64_t published, Partition partitioning) {
+    if (partitioning == Partition::NONE || published == UNKNOWN_DATE) {
+        return partitioning == Partition::NONE ? 0 : UNKNOWN_DATE;
+    }
+    int64_t days = published / SECONDS_PER_DAY - (published % SECONDS_PER_DAY < 0);
+    switch (partitioning) {
+        case Partition::WEEK: {
+            //1970-01-01 was a Thursday, three days after the Monday that starts its week
+            int64_t weeks = (days + 3) / 7 - ((days + 3) % 7 < 0);
+            return (weeks * 7 - 3) * SECONDS_PER_DAY;
+        }
+        case Partition::MONTH: {
+            int64_t year, month, day;
+            civil_from_days(days, year, month, day);
+            return days_from_civil(year, month, 1) * SECONDS_PER_DAY;
+        }
+        default:
+            return days * SECONDS_PER_DAY;
+    }
+}
+
+void MetadataBuilder::add(int64_t time, const std::string &site, const std::string &language) {
+    published.push_back(time);
+    const std::string *column_values[DICTIONARY_COLUMN_COUNT] = {&site, &language};
+    for (size_t c = 0; c < DICTIONARY_COLUMN_COUNT; ++c) {
+        auto entry = values[c].try_emplace(*column_values[c], static_cast<uint32_t>(values[c].size())).first;
+        codes[c].push_back(entry->second);
+    }
+}
+
+Metadata MetadataBuilder::finish() {
+    //Renumber each dictionary into value order, so that codes compare like their values
+    std::array<std::vector<std::string>, DICTIONARY_COLUMN_COUNT> dictionaries;
+    for (size_t c = 0; c < DICTIONARY_COLUMN_COUNT; ++c) {
+        std::vector<const std::pair<const std::string, uint32_t> *> order;
+        order.reserve(values[c].size());
+        for (const auto &entry: values[c]) {
+            order.push_back(&entry);
+        }
+        std::sort(order.begin(), order.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+        std::vector<uint32_t> renumbered(order.size());
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            dictionaries[c].push_back(order[rank]->first);
+            renumbered[order[rank]->second] = static_cast<uint32_t>(rank);
+        }
+        for (uint32_t &code: codes[c]) {
+            code = renumbered[code];
+        }
+    }
+    Metadata metadata(std::move(published), std::move(dictionaries), std::move(codes));
+    published = {};
+    values = {};
+    codes = {};
+    return metadata;
+}
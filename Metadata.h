@@ -0,0 +1,155 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Metadata.h
+ * @date:           10-19-2026
+ * @description:    Columnar metadata of a segment's documents, one value per local ordinal in each column:
+ *                      - PUBLISHED: fixed-width publication times (seconds since the Unix epoch, UTC)
+ *                      - SITE, LANGUAGE: dictionary encoded. The distinct values of the segment are kept sorted,
+ *                        so a code is its value's rank and an equality (or prefix) filter is a range of codes
+ *                        found by binary search in the dictionary
+ *                  Every column has a zone map: the smallest and largest value of each run of ZONE_SIZE
+ *                  ordinals. select() turns a range filter into a bitmap of ordinals: zones that cannot match
+ *                  are skipped, zones that match whole are filled, and the others are compared 64 values at a
+ *                  time into bitmap words.
+ *                  MetadataBuilder collects the columns of the documents being indexed.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_METADATA_H
+#define INC_22S_FINAL_PROJ_METADATA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Article.h"
+#include "Bitmap.h"
+
+/// \description Metadata columns queries can filter on
+enum class Column : uint8_t {
+    PUBLISHED,
+    SITE,
+    LANGUAGE,
+};
+constexpr size_t COLUMN_COUNT = 3;
+/// \description SITE and LANGUAGE: the columns holding dictionary codes
+constexpr size_t DICTIONARY_COLUMN_COUNT = COLUMN_COUNT - 1;
+
+/// \description Periods of publication time an index can keep its segments apart by
+enum class Partition : uint8_t {
+    NONE,
+    DAY,
+    WEEK,
+    MONTH,
+};
+
+class Metadata {
+public:
+    static constexpr size_t ZONE_SIZE = 1024;
+
+    /// \description Smallest and largest value of a run of ordinals (codes, in dictionary columns)
+    struct Zone {
+        int64_t low;
+        int64_t high;
+    };
+
+private:
+    std::vector<int64_t> published;
+    //Sorted distinct values, and the code of every ordinal, of each dictionary column
+    std::array<std::vector<std::string>, DICTIONARY_COLUMN_COUNT> dictionaries;
+    std::array<std::vector<uint32_t>, DICTIONARY_COLUMN_COUNT> codes;
+    std::array<std::vector<Zone>, COLUMN_COUNT> zones;
+
+    /// \return size_t      -> Position of dictionary column "column" in dictionaries and codes
+    static size_t dictionary(Column column) { return static_cast<size_t>(column) - 1; }
+
+public:
+    Metadata() = default;
+
+    /// \param published    -> Publication time of every ordinal
+    /// \param dictionaries -> Sorted distinct values of each dictionary column
+    /// \param codes        -> Code of every ordinal in each dictionary column
+    Metadata(std::vector<int64_t> &&published,
+             std::array<std::vector<std::string>, DICTIONARY_COLUMN_COUNT> &&dictionaries,
+             std::array<std::vector<uint32_t>, DICTIONARY_COLUMN_COUNT> &&codes);
+
+    /// \return size_t      -> Number of ordinals
+    size_t size() const { return published.size(); }
+
+    /// \return int64_t     -> Publication time of the document at "local", or UNKNOWN_DATE
+    int64_t published_at(uint32_t local) const { return published[local]; }
+
+    /// \param column       -> SITE or LANGUAGE
+    /// \return string      -> Value of the document at "local" (empty when unknown)
+    const std::string &value(Column column, uint32_t local) const {
+        return dictionaries[dictionary(column)][codes[dictionary(column)][local]];
+    }
+
+    /// \param column       -> SITE or LANGUAGE
+    /// \param value        -> Lowercase value to look for
+    /// \param prefix       -> Whether every value starting with "value" matches
+    /// \return pair        -> [first, last] codes of the matching values; first > last when none matches
+    std::pair<int64_t, int64_t> code_range(Column column, const std::string &value, bool prefix) const;
+
+    /// \param column       -> Column to inspect
+    /// \return Zone        -> Smallest and largest value of the column over every ordinal; low > high when the
+    ///                     segment is empty
+    Zone bounds(Column column) const;
+
+    /// \param column       -> Column to filter on
+    /// \param low          -> Smallest value (or code) to keep
+    /// \param high         -> Largest value (or code) to keep
+    /// \return Bitmap      -> Ordinals whose value lies in [low, high]
+    Bitmap select(Column column, int64_t low, int64_t high) const;
+
+    /// \param text         -> ISO 8601 time, e.g. "2018-01-04T04:00:00.000+02:00" (date alone, time and zone
+    ///                     are optional; no zone means UTC)
+    /// \param seconds      -> Receives the time in seconds since the Unix epoch
+    /// \return bool        -> Whether "text" is such a time. A day the month does not have (e.g. "2026-02-29") is
+    ///                     rejected
+    static bool parse_time(const std::string &text, int64_t &seconds);
+
+    /// \param text         -> Period "2018", "2018-03" or "2018-03-14", or a range of two of them "a..b", either
+    ///                     side possibly left out ("2018-03..", "..2018-02-15")
+    /// \param low          -> Receives the first second of the range. Documents without a date never fall in it
+    /// \param high         -> Receives the last second of the range (the end of "b"'s period)
+    /// \return bool        -> Whether "text" is such a range. Days the month does not have are rejected
+    static bool parse_date_range(const std::string &text, int64_t &low, int64_t &high);
+
+    /// \param seconds      -> Seconds since the Unix epoch
+    /// \return string      -> Its UTC date, "YYYY-MM-DD"
+    static std::string format_date(int64_t seconds);
+
+    /// \param published    -> Publication time, or UNKNOWN_DATE
+    /// \param partitioning -> Length of the periods
+    /// \return int64_t     -> First second of the UTC day, week (from Monday) or month holding "published".
+    ///                     UNKNOWN_DATE stays UNKNOWN_DATE, and every time is in period 0 when "partitioning" is NONE
+    static int64_t partition(int64_t published, Partition partitioning);
+};
+
+class MetadataBuilder {
+private:
+    std::vector<int64_t> published;
+    //Value -> code of each dictionary column, codes in first-seen order; finish() renumbers them into value order
+    std::array<std::unordered_map<std::string, uint32_t>, DICTIONARY_COLUMN_COUNT> values;
+    std::array<std::vector<uint32_t>, DICTIONARY_COLUMN_COUNT> codes;
+
+public:
+    /// \param published    -> Publication time of the next ordinal, or UNKNOWN_DATE
+    /// \param site         -> Its site
+    /// \param language     -> Its language
+    void add(int64_t published, const std::string &site, const std::string &language);
+
+    /// \param article      -> Parsed article taking the next ordinal
+    void add(const Article &article) { add(article.published, article.site, article.language); }
+
+    /// \return size_t      -> Number of ordinals added
+    size_t size() const { return published.size(); }
+
+    /// \return Metadata    -> The encoded columns. The builder is left empty
+    Metadata finish();
+};
+
+#endif //INC_22S_FINAL_PROJ_METADATA_H
@@ -0,0 +1,44 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       MetadataTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the date parsing behind publication times and date filters: days are checked
+ *                  against the length of their month, leap years included.
+ */
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+#include "Metadata.h"
+
+TEST_CASE("Metadata::parse_time rejects days the month does not have", "[Metadata]") {
+    int64_t seconds = 0;
+    CHECK(Metadata::parse_time("2018-01-31T04:00:00Z", seconds));
+    CHECK(Metadata::format_date(seconds) == "2018-01-31");
+    CHECK(Metadata::parse_time("2024-02-29", seconds));
+    CHECK(Metadata::format_date(seconds) == "2024-02-29");
+    CHECK(Metadata::parse_time("2000-02-29", seconds));
+
+    CHECK_FALSE(Metadata::parse_time("2026-02-31", seconds));
+    CHECK_FALSE(Metadata::parse_time("2026-02-29T10:00:00", seconds));
+    CHECK_FALSE(Metadata::parse_time("1900-02-29", seconds));
+    CHECK_FALSE(Metadata::parse_time("2018-04-31", seconds));
+    CHECK_FALSE(Metadata::parse_time("2018-12-32", seconds));
+    CHECK_FALSE(Metadata::parse_time("2018-12-00", seconds));
+}
+
+TEST_CASE("Metadata::parse_date_range rejects days the month does not have", "[Metadata]") {
+    int64_t low = 0, high = 0;
+    REQUIRE(Metadata::parse_date_range("2024-02-29", low, high));
+    CHECK(Metadata::format_date(low) == "2024-02-29");
+    CHECK(Metadata::format_date(high) == "2024-02-29");
+    REQUIRE(Metadata::parse_date_range("2018-02..2018-03-31", low, high));
+    CHECK(Metadata::format_date(low) == "2018-02-01");
+    CHECK(Metadata::format_date(high) == "2018-03-31");
+
+    CHECK_FALSE(Metadata::parse_date_range("2026-02-31", low, high));
+    CHECK_FALSE(Metadata::parse_date_range("2026-02-29..", low, high));
+    CHECK_FALSE(Metadata::parse_date_range("..2018-06-31", low, high));
+    CHECK_FALSE(Metadata::parse_date_range("2018-11-31..2018-12-31", low, high));
+}
@@ -0,0 +1,104 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       NodePool.h
+ * @date:           10-19-2026
+ * @description:    Slab allocator for fixed-size nodes. Objects are carved out of large slabs and
+ *                  recycled through an intrusive free list, so building a tree with millions of
+ *                  nodes costs one heap allocation per slab instead of one per node.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_NODEPOOL_H
+#define INC_22S_FINAL_PROJ_NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+template<typename T, size_t SLAB_SIZE = 1024>
+class NodePool {
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<Slot *> slabs;
+    Slot *free_list = nullptr;
+    //Number of never-used slots left at the end of the newest slab
+    size_t slab_remaining = 0;
+
+    Slot *grab_slot() {
+        if (free_list != nullptr) {
+            Slot *slot = free_list;
+            free_list = slot->next;
+            return slot;
+        }
+        if (slab_remaining == 0) {
+            slabs.push_back(static_cast<Slot *>(::operator new(sizeof(Slot) * SLAB_SIZE)));
+            slab_remaining = SLAB_SIZE;
+        }
+        return slabs.back() + (SLAB_SIZE - slab_remaining--);
+    }
+
+public:
+    NodePool() = default;
+
+    NodePool(const NodePool &) = delete;
+
+    NodePool &operator=(const NodePool &) = delete;
+
+    NodePool(NodePool &&pool) noexcept { *this = std::move(pool); }
+
+    NodePool &operator=(NodePool &&pool) noexcept {
+        if (this != &pool) {
+            release();
+            slabs = std::move(pool.slabs);
+            free_list = pool.free_list;
+            slab_remaining = pool.slab_remaining;
+            pool.slabs.clear();
+            pool.free_list = nullptr;
+            pool.slab_remaining = 0;
+        }
+        return *this;
+    }
+
+    ~NodePool() { release(); }
+
+    /// \param args         -> Arguments forwarded to T's constructor
+    /// \return T*          -> A newly constructed object living inside the pool
+    /// \description        -> Constructs a T in a recycled or fresh slot
+    template<typename... Args>
+    T *create(Args &&... args) {
+        Slot *slot = grab_slot();
+        try {
+            return new(slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            slot->next = free_list;
+            free_list = slot;
+            throw;
+        }
+    }
+
+    /// \param object       -> Object previously returned by create
+    /// \description        -> Runs the destructor and puts the slot back on the free list
+    void destroy(T *object) {
+        object->~T();
+        Slot *slot = reinterpret_cast<Slot *>(object);
+        slot->next = free_list;
+        free_list = slot;
+    }
+
+    /// \description        -> Returns every slab to the system. Objects still alive are NOT destructed,
+    ///                     the owner must destroy them first
+    void release() {
+        for (Slot *slab: slabs) {
+            ::operator delete(slab);
+        }
+        slabs.clear();
+        free_list = nullptr;
+        slab_remaining = 0;
+    }
+};
+
+#endif //INC_22S_FINAL_PROJ_NODEPOOL_H
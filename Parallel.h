@@ -0,0 +1,185 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Parallel.h
+ * @date:           10-19-2026
+ * @description:    Structured parallelism on top of ThreadPool: task groups, parallel_for,
+ *                  parallel_reduce and when_all. Waiting never blocks a thread while there is
+ *                  pool work it could run instead, so these can be nested inside pool tasks.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_PARALLEL_H
+#define INC_22S_FINAL_PROJ_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "thread_pool.h"
+
+/// \param pool         -> Pool the waiting thread may help
+/// \param done         -> Predicate that becomes true once the wait is over
+/// \description        -> Runs pending pool tasks until "done" holds; yields when there is nothing to run
+template<typename Predicate>
+void help_until(ThreadPool &pool, Predicate &&done) {
+    while (!done()) {
+        if (!pool.try_run_pending()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+class TaskGroup {
+private:
+    ThreadPool &pool;
+    std::atomic<size_t> pending{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+public:
+    explicit TaskGroup(ThreadPool &pool) : pool(pool) {}
+
+    TaskGroup(const TaskGroup &) = delete;
+
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    ~TaskGroup() {
+        help_until(pool, [this] { return pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    /// \param task         -> Callable with no arguments
+    /// \description        -> Spawns "task" as part of this group. The first exception thrown by any task
+    ///                     of the group is rethrown by wait(). If the task cannot be queued, run() throws
+    ///                     and the group does not wait for it
+    template<typename F>
+    void run(F &&task) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        try {
+            pool.execute([this, task = std::forward<F>(task)]() mutable {
+                try {
+                    task();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+                pending.fetch_sub(1, std::memory_order_release);
+            });
+        } catch (...) {
+            //The task was never queued (e.g. its node could not be allocated), so wait() must not count it
+            pending.fetch_sub(1, std::memory_order_release);
+            throw;
+        }
+    }
+
+    /// \description        -> Waits for every task of the group, executing pool work meanwhile
+    void wait() {
+        help_until(pool, [this] { return pending.load(std::memory_order_acquire) == 0; });
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error) {
+            std::exception_ptr thrown = error;
+            error = nullptr;
+            std::rethrow_exception(thrown);
+        }
+    }
+
+    ThreadPool &get_pool() { return pool; }
+};
+
+/// \param pool         -> Pool executing the work
+/// \param count        -> Number of items to split
+/// \return size_t      -> Grain size giving each worker ~8 chunks, so stealing can even out uneven items
+inline size_t default_grain(const ThreadPool &pool, size_t count) {
+    size_t chunks = std::max<size_t>(1, pool.size() * 8);
+    return std::max<size_t>(1, count / chunks);
+}
+
+namespace parallel_detail {
+template<typename F>
+void split_range(TaskGroup &group, size_t first, size_t last, size_t grain, F &fn) {
+    //Hand the upper half of the range to whoever steals it, keep splitting the lower half
+    while (last - first > grain) {
+        size_t middle = first + (last - first) / 2;
+        group.run([&group, middle, last, grain, &fn] { split_range(group, middle, last, grain, fn); });
+        last = middle;
+    }
+    for (size_t i = first; i < last; ++i) {
+        fn(i);
+    }
+}
+}
+
+/// \param pool         -> Pool executing the work
+/// \param first        -> First index of the range
+/// \param last         -> One past the last index of the range
+/// \param grain        -> Largest chunk run without splitting, 0 picks one from the range and pool size
+/// \param fn           -> Callable taking a size_t index
+/// \description        -> Calls fn(i) for every i in [first, last) using recursive range splitting
+template<typename F>
+void parallel_for(ThreadPool &pool, size_t first, size_t last, size_t grain, F &&fn) {
+    if (first >= last) return;
+    if (grain == 0) grain = default_grain(pool, last - first);
+    TaskGroup group(pool);
+    parallel_detail::split_range(group, first, last, grain, fn);
+    group.wait();
+}
+
+/// \param pool         -> Pool executing the work
+/// \param first        -> First index of the range
+/// \param last         -> One past the last index of the range
+/// \param grain        -> Chunk size, 0 picks one from the range and pool size
+/// \param identity     -> Starting value of every chunk
+/// \param map          -> Callable (size_t first, size_t last, T accumulator) -> T folding one chunk
+/// \param combine      -> Associative callable (T, T) -> T joining two chunk results
+/// \return T           -> Chunk results combined in index order, so the result is deterministic
+template<typename T, typename Map, typename Combine>
+T parallel_reduce(ThreadPool &pool, size_t first, size_t last, size_t grain, T identity,
+                  Map &&map, Combine &&combine) {
+    if (first >= last) return identity;
+    if (grain == 0) grain = default_grain(pool, last - first);
+    size_t chunk_count = (last - first + grain - 1) / grain;
+    std::vector<T> partials(chunk_count, identity);
+    parallel_for(pool, 0, chunk_count, 1, [&](size_t chunk) {
+        size_t chunk_first = first + chunk * grain;
+        size_t chunk_last = std::min(last, chunk_first + grain);
+        partials[chunk] = map(chunk_first, chunk_last, std::move(partials[chunk]));
+    });
+    T result = std::move(identity);
+    for (T &partial: partials) {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
+
+/// \param pool         -> Pool executing the futures' tasks
+/// \param futures      -> Futures returned by ThreadPool::enqueue
+/// \return vector<T>   -> Every result, in order. Rethrows the first stored exception
+template<typename T>
+std::vector<T> when_all(ThreadPool &pool, std::vector<std::future<T>> &futures) {
+    std::vector<T> results;
+    results.reserve(futures.size());
+    for (std::future<T> &future: futures) {
+        help_until(pool, [&future] {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+/// \param pool         -> Pool executing the futures' tasks
+/// \param futures      -> Futures returned by ThreadPool::enqueue
+/// \description        -> Waits for every future, rethrowing the first stored exception
+inline void when_all(ThreadPool &pool, std::vector<std::future<void>> &futures) {
+    for (std::future<void> &future: futures) {
+        help_until(pool, [&future] {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        future.get();
+    }
+}
+
+#endif //INC_22S_FINAL_PROJ_PARALLEL_H
@@ -0,0 +1,39 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       ParallelTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the task groups: a task that cannot be queued is not waited for, and the group
+ *                  keeps working after it.
+ */
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include "Parallel.h"
+
+/// \description A task that can be copied but throws when the pool moves it into a task node
+struct UnmovableTask {
+    std::atomic<int> *runs;
+
+    explicit UnmovableTask(std::atomic<int> *runs) : runs(runs) {}
+
+    UnmovableTask(const UnmovableTask &other) = default;
+
+    UnmovableTask(UnmovableTask &&) { throw std::runtime_error("task cannot be moved"); }
+
+    void operator()() const { ++*runs; }
+};
+
+TEST_CASE("TaskGroup::run throws and forgets a task that cannot be queued", "[Parallel]") {
+    ThreadPool pool(2);
+    std::atomic<int> runs{0};
+    TaskGroup group(pool);
+    UnmovableTask task(&runs);
+    CHECK_THROWS_AS(group.run(task), std::runtime_error);
+
+    //wait() returns instead of waiting for the lost task, and later tasks still run
+    group.run([&runs] { ++runs; });
+    group.wait();
+    CHECK(runs == 1);
+}
@@ -12,147 +12,229 @@ Article *Parser::parse_json(const std::filesystem::directory_entry &json_file) {
     //3- Close the stream
     file.close();
 
-    //4- Parsing "json_string" into "JSON_document" using rapidjson
-    rapidjson::Document JSON_document;
-    JSON_document.Parse(json_string.c_str());
+    return parse_json_string(json_string);
+}
 
+/// \param value        -> JSON object
+/// \param name         -> Member name
+/// \return bool        -> Whether "value" has a string member called "name"
+static bool has_string(const rapidjson::Value &value, const char *name) {
+    auto member = value.FindMember(name);
+    return member != value.MemberEnd() && member->value.IsString();
+}
 
-    //5- Store "persons name" into Article
-    Article *article = new Article();
-    auto &entities = JSON_document["entities"]; //an element of the JSON file containing arrays
-    auto &persons = entities["persons"]; //an array
-    for (const auto &person: persons.GetArray()) {
-        //add person_map names to article vector named "persons"
-        article->persons.emplace_back(person["name"].GetString());
+/// \return string      -> "value" in lowercase
+static std::string lowercase(std::string value) {
+    for (char &c: value) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     }
+    return value;
+}
 
-    //6- Store "organizations name" into Article
-    auto &organizations = entities["organizations"]; //an array
-    for (const auto &organization: organizations.GetArray()) {
-        //add organization names to article vector named "organizations"
-        article->organizations.emplace_back(organization["name"].GetString());
+/// \param entities     -> The "entities" object of an article
+/// \param kind         -> "persons" or "organizations"
+/// \param names        -> Receives the normalized "name" of every entity of that kind
+static void collect_entity_names(const rapidjson::Value &entities, const char *kind, std::vector<std::string> &names) {
+    auto list = entities.FindMember(kind);
+    if (list == entities.MemberEnd() || !list->value.IsArray()) {
+        return;
     }
-
-    //7- Tokenize, lowercase, and stemming
-    article->text = JSON_document["text"].GetString();
-    std::istringstream ss(article->text);
-    std::string token;
-    std::unordered_set<std::string> used_tokens;
-    HashMap<std::string, std::string> stem_cache(50);
-    while (std::getline(ss, token, ' ')) {
-        //if stop-word, ignore.
-        if (stop_words.find(token) != stop_words.end()) {
-            continue;
+    for (const auto &entity: list->value.GetArray()) {
+        if (entity.IsObject() && has_string(entity, "name")) {
+            names.push_back(EntityDictionary::normalize(entity["name"].GetString()));
         }
-        //punctuation removal
-        char *token_ptr = token.data();
+    }
+}
 
-        // Remove all characters that are not alphabetic from token
-        for (const char c: token) {
-            if (isalpha(c)) {
-                *token_ptr++ = c;
-            }
-        }
+bool Parser::parse_retraction(const std::string &json_string, std::string &uuid) {
+    rapidjson::Document JSON_document;
+    JSON_document.Parse(json_string.c_str());
+    if (JSON_document.HasParseError() || !JSON_document.IsObject() || !has_string(JSON_document, "uuid")) {
+        return false;
+    }
+    auto deleted = JSON_document.FindMember("deleted");
+    if (deleted == JSON_document.MemberEnd() || !deleted->value.IsBool() || !deleted->value.GetBool()) {
+        return false;
+    }
+    uuid = JSON_document["uuid"].GetString();
+    return true;
+}
 
-        // If the token_ptr hasn't changed, then no alphabetic characters were found, so we skip this token
-        if (token.c_str() == token_ptr) {
-            continue;
+bool Parser::normalize_token(std::string &token, HashMap<std::string, std::string> &stem_cache) {
+    //if stop-word, ignore.
+    if (stop_words.find(token) != stop_words.end()) {
+        return false;
+    }
+    //punctuation removal
+    char *token_ptr = token.data();
+
+    // Remove all characters that are not alphabetic from token
+    for (const char c: token) {
+        if (isalpha(c)) {
+            *token_ptr++ = c;
         }
+    }
 
-        // Truncate punctuation that may appear at the end of the character
-        token.resize(token_ptr - token.c_str());
+    // If the token_ptr hasn't changed, then no alphabetic characters were found, so we skip this token
+    if (token.c_str() == token_ptr) {
+        return false;
+    }
 
-        // Convert all alphabetic characters to lowercase
-        for (char &c: token) {
-            c = (char) tolower(c);
-        }
+    // Truncate punctuation that may appear at the end of the character
+    token.resize(token_ptr - token.c_str());
+
+    // Convert all alphabetic characters to lowercase
+    for (char &c: token) {
+        c = (char) tolower(c);
+    }
 
+    auto stem = stem_cache.find(token);
+    if (stem != nullptr) {
+        token = *stem;
+    } else {
         std::string stemmed = token;
-        auto stem = stem_cache.find(token);
-        if (stem != nullptr) {
-            stemmed = *stem;
-        } else {
-            stemmed = token;
-            Porter2Stemmer::stem(stemmed);
-            stem_cache.insert({token, stemmed});
-        }
+        Porter2Stemmer::stem(stemmed);
+        stem_cache.insert({token, stemmed});
+        token = std::move(stemmed);
+    }
 
-        //SECOND STOP WORD CHECK... because some NON stop words, when stemmed result in stop words
-        if (stop_words.find(stemmed) != stop_words.end()) {
-            continue;
+    //SECOND STOP WORD CHECK... because some NON stop words, when stemmed result in stop words
+    return stop_words.find(token) == stop_words.end();
+}
+
+Article *Parser::parse_json_string(const std::string &json_string) {
+    //4- Parsing "json_string" into "JSON_document" using rapidjson
+    rapidjson::Document JSON_document;
+    JSON_document.Parse(json_string.c_str());
+    if (JSON_document.HasParseError() || !JSON_document.IsObject() || !has_string(JSON_document, "uuid") ||
+        !has_string(JSON_document, "text")) {
+        return nullptr;
+    }
+
+    //5- Store "persons name" into Article
+    Article *article = new Article();
+    auto entities = JSON_document.FindMember("entities"); //an element of the JSON file containing arrays
+    if (entities != JSON_document.MemberEnd() && entities->value.IsObject()) {
+        //add person names to article vector named "persons"
+        collect_entity_names(entities->value, "persons", article->persons);
+
+        //6- Store "organizations name" into Article
+        collect_entity_names(entities->value, "organizations", article->organizations);
+    }
+
+    //7- Tokenize, lowercase, and stemming. Every word counts as a position, even the ones not indexed
+    article->text = JSON_document["text"].GetString();
+    std::unordered_map<std::string, size_t> used_tokens;
+    HashMap<std::string, std::string> stem_cache(50);
+    uint32_t position = 0;
+    for_each_word(article->text, [&](std::string &token) {
+        uint32_t word = position++;
+        if (!normalize_token(token, stem_cache)) {
+            return;
         }
 
-        //add token to list of tokens in the article.
-        if (used_tokens.find(stemmed) != used_tokens.end()) {
-            continue;
-        } else {
-            used_tokens.insert(stemmed);
+        //add token to list of tokens in the article, and its position
+        auto [used, inserted] = used_tokens.try_emplace(token, article->tokens.size());
+        if (inserted) {
+            article->tokens.emplace_back(token);
+            article->positions.emplace_back();
         }
-        article->tokens.emplace_back(stemmed);
-    }
+        article->positions[used->second].push_back(word);
+    });
 
     //8- Store ID
     article->id = JSON_document["uuid"].GetString();
 
-    //9- Get Title
-    article->title = JSON_document["title"].GetString();
+    //9- Get Title, and index its words as a field of their own
+    if (has_string(JSON_document, "title")) {
+        article->title = JSON_document["title"].GetString();
+        std::unordered_set<std::string> title_terms;
+        for_each_word(article->title, [&](std::string &token) {
+            if (normalize_token(token, stem_cache) && title_terms.insert(token).second) {
+                article->title_tokens.push_back(token);
+            }
+        });
+    }
+
+    //10- Metadata: publication time (top level, or the thread's), site and language
+    const rapidjson::Value *published = has_string(JSON_document, "published") ? &JSON_document["published"] : nullptr;
+    auto thread = JSON_document.FindMember("thread");
+    if (thread != JSON_document.MemberEnd() && thread->value.IsObject()) {
+        if (published == nullptr && has_string(thread->value, "published")) {
+            published = &thread->value["published"];
+        }
+        if (has_string(thread->value, "site")) {
+            article->site = lowercase(thread->value["site"].GetString());
+        }
+    }
+    if (published == nullptr || !Metadata::parse_time(published->GetString(), article->published)) {
+        article->published = UNKNOWN_DATE;
+    }
+    if (has_string(JSON_document, "language")) {
+        article->language = lowercase(JSON_document["language"].GetString());
+    }
 
     return article;
 }
 
-void Parser::parse(const std::filesystem::path &root_folder_path) {
-    auto data_dir = std::filesystem::directory_iterator(root_folder_path);
+void Parser::collect_json_files(const std::filesystem::path &folder_path,
+                                std::vector<std::filesystem::directory_entry> &json_files) {
+    auto data_dir = std::filesystem::directory_iterator(folder_path);
     for (const auto &element: data_dir) {
         if (element.is_directory()) {
             // Recursively enter the next directory
-            parse(element.path());
+            collect_json_files(element.path(), json_files);
         } else if (element.path().extension() == ".json") {
-            //1- Submit parse_json routine to pool and move it into the future_queue
-            future_queue.push_back(thread_pool.enqueue(&Parser::parse_json, this, element));
+            json_files.push_back(element);
         }
     }
 }
 
+void Parser::parse(const std::filesystem::path &root_folder_path) {
+    std::vector<std::filesystem::directory_entry> json_files;
+    collect_json_files(root_folder_path, json_files);
+
+    //1- Reserve one slot per file, then let the pool fill the slots in parallel
+    size_t first = articles.size();
+    articles.resize(first + json_files.size(), nullptr);
+    parallel_for(thread_pool, 0, json_files.size(), 0, [this, first, &json_files](size_t i) {
+        articles[first + i] = parse_json(json_files[i]);
+    });
+}
 
-
-AvlTree<std::string, Article *> Parser::build_AVL_tree() {
-    AvlTree<std::string, Article *> article_tree;
-
-    //set the total number of article indexed
-    article_tree.set_total_articles(future_queue.size());
-    for (std::future<Article *> &future_article: future_queue) {
-        Article *article = future_article.get();
-        //add article tokens to article_tree total tokens
-        article_tree.add_tokens(article->tokens.size());
-        k1.insert(article->persons.cbegin(), article->persons.cend());
-        k2.insert(article->organizations.cbegin(), article->organizations.cend());
-        goto persons;
-        std::async([this, article] () {
-            for (std::string &person: article->persons) {
-                auto person_set = person_map.find(person);
-                if (person_set != nullptr) {
-                    person_set->insert(article);
-                } else {
-                    person_map.insert({person, {article}});
-                }
+void Parser::build_external(const std::filesystem::path &root_folder_path, SpimiBuilder &builder) {
+    std::vector<std::filesystem::directory_entry> json_files;
+    collect_json_files(root_folder_path, json_files);
+
+    //1- Parse a batch in parallel, then hand it to the builder in file order and free it
+    size_t batch_size = std::max<size_t>(1, thread_pool.size() * 16);
+    std::vector<Article *> batch;
+    for (size_t first = 0; first < json_files.size(); first += batch_size) {
+        size_t last = std::min(first + batch_size, json_files.size());
+        batch.assign(last - first, nullptr);
+        parallel_for(thread_pool, first, last, 1, [this, first, &batch, &json_files](size_t i) {
+            batch[i - first] = parse_json(json_files[i]);
+        });
+        for (Article *article: batch) {
+            if (article == nullptr) {
+                continue;
             }
-        }).wait();
-        std::async([this, article] () {
-            for (std::string &organization: article->organizations) {
-                auto orgs_set = orgs_map.find(organization);
-                if (orgs_set != nullptr) {
-                    orgs_set->insert(article);
-                } else {
-                    orgs_map.insert({organization, {article}});
-                }
-            }
-        }).wait(); persons:
-        for (std::string &token: article->tokens) {
-            article_tree.insert(token, article);
+            builder.add(*article);
+            delete article;
+        }
+    }
+    builder.finish();
+}
+
+void Parser::build_index(Index &index) {
+    for (Article *article: articles) {
+        //Malformed files were skipped by parse_json
+        if (article == nullptr) {
+            continue;
         }
-        //t1.wait();
-        //t2.wait();
-        article->tokens.clear();
+        //The index interns the entities and builds their postings with the segment holding the article
+        index.add(article);
     }
-    return article_tree;
+    articles.clear();
+    index.flush();
 }
@@ -5,7 +5,8 @@
  * @description:    This class is the parser of the project
  *                  It is responsible for:
  *                      - reading and processing JSON files asynchronously
- *                      - Storing processed JSON file (Article) into std::deque
+ *                      - Storing processed JSON file (Article) into std::vector
+ *                  Entity names are normalized (EntityDictionary::normalize) while parsing, on the pool.
  */
 
 #ifndef INC_22S_FINAL_PROJ_PARSER_H
@@ -22,6 +23,8 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <unordered_map>
 #include <unordered_set>
 #include <set>
 #include "HashMap.h"
@@ -29,8 +32,11 @@
 #include "Article.h"
 #include "rapidjson/document.h"
 #include "thread_pool.h"
+#include "Parallel.h"
 #include "porter2_stemmer.h"
-#include "AvlTree.h"
+#include "Index.h"
+#include "Metadata.h"
+#include "SpimiBuilder.h"
 
 //stop word list borrowed from: https://www.webconfs.com/stop-words.php
 static std::unordered_set<std::string> stop_words = {
@@ -171,31 +177,82 @@ static std::unordered_set<std::string> stop_words = {
 
 class Parser {
 private:
-    /// \description Parser::parse will move futures of AVL trees into this vector
-    std::vector<std::future<Article *>> future_queue;
-    ThreadPool thread_pool;
+    /// \description Parser::parse stores every processed article here, in file discovery order
+    std::vector<Article *> articles;
+    /// \description Set only when the parser was not handed a pool and had to start its own
+    std::unique_ptr<ThreadPool> owned_pool;
+    ThreadPool &thread_pool;
+
+    /// \param folder_path  -> Path to a folder within the filesystem
+    /// \param json_files   -> Receives every ".json" file under "folder_path"
+    /// \description        -> Recursively collects the JSON files to parse
+    static void collect_json_files(const std::filesystem::path &folder_path,
+                                   std::vector<std::filesystem::directory_entry> &json_files);
 
     /// \param json_file    -> Path to JSON file within the filesystem
-    /// \return AVL tree    -> A small AVL tree :)
-    /// \description        -> Reads, parses, extracts, and process data (persons, organizations,
-    ///                     text) from raw JSON file and populate a small AVL tree
+    /// \return Article*    -> The processed article, or nullptr if the file is malformed
+    /// \description        -> Reads a raw JSON file and hands it to parse_json_string
     Article *parse_json(const std::filesystem::directory_entry &json_file);
 
 public:
+    /// \param text         -> Text to split into words: article text and titles, and query phrases
+    /// \param f            -> Called with every word in order, the runs of characters between whitespace (' ',
+    ///                     '\t', '\n', ...). The indexer numbers positions and the phrase matcher numbers offsets
+    ///                     by this one split, so the two always agree
+    template<typename F>
+    static void for_each_word(const std::string &text, F &&f) {
+        std::string word;
+        for (size_t i = 0; i < text.size();) {
+            while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+            if (i > start) {
+                word.assign(text, start, i - start);
+                f(word);
+            }
+        }
+    }
+
+    /// \param token        -> One whitespace-separated word, replaced by its index term
+    /// \param stem_cache   -> word -> stem cache shared by the words of one text
+    /// \return bool        -> False when the word is not indexed (stop word, no letters)
+    /// \description        -> Strips non-letters, lowercases and stems a word the way articles are indexed
+    static bool normalize_token(std::string &token, HashMap<std::string, std::string> &stem_cache);
+
+    /// \param json_string  -> One article in the Kaggle JSON format
+    /// \return Article*    -> The processed article, or nullptr if the JSON is malformed or has no uuid/text
+    /// \description        -> Extracts and processes data (persons, organizations, text, publication time, site
+    ///                     and language) from raw JSON
+    static Article *parse_json_string(const std::string &json_string);
+
+    /// \param json_string  -> One feed record
+    /// \param uuid         -> Receives the uuid of the retracted article
+    /// \return bool        -> Whether the record is a retraction: {"uuid": "...", "deleted": true}
+    static bool parse_retraction(const std::string &json_string, std::string &uuid);
+
+    /// \description        -> Parser with a private pool using every core
+    Parser() : owned_pool(std::make_unique<ThreadPool>()), thread_pool(*owned_pool) {}
+
+    /// \param pool         -> Shared pool to parse on, so ingest does not oversubscribe cores used elsewhere
+    explicit Parser(ThreadPool &pool) : thread_pool(pool) {}
+
     ///
     /// \param root_folder_path            -> Path the kaggle folder (data set folder)
-    /// \description                       -> asynchronously call "parse_folder" on EACH folder within
-    ///                                     "root_folder_path" and store "Future" variables within the Parser::future_queue
+    /// \description                       -> Collects every JSON file under "root_folder_path", then parses them
+    ///                                     with parallel_for over the pool and appends the results to Parser::articles
     void parse(const std::filesystem::path &root_folder_path);
 
-    std::set<std::string> k1, k2;
-    /// \return set of AVL trees    -> AVL trees returns by each threads
-    /// \description                -> "Move all variables from Parser::future_queue into the Parser::articles,
-    ///                             where they can be accessed. Optimally, this should only be called once and
-    ///                             should be called before accessing Parser::articles
-    AvlTree<std::string, Article *> build_AVL_tree();
+    /// \param root_folder_path    -> Path the kaggle folder (data set folder)
+    /// \param builder             -> External-memory index build receiving every article
+    /// \description               -> Parses the dataset in small batches and streams each batch into "builder",
+    ///                            so no more than one batch of articles is ever held in memory
+    void build_external(const std::filesystem::path &root_folder_path, SpimiBuilder &builder);
 
-    HashMap<std::string, std::set<Article*>> orgs_map, person_map;
+    /// \param index                -> Index receiving the articles
+    /// \description                -> Hands every article in Parser::articles to "index" (which takes
+    ///                             ownership) and flushes it, so the new articles become searchable.
+    ///                             Can be called after each Parser::parse to grow the index incrementally
+    void build_index(Index &index);
 };
 
 
@@ -0,0 +1,45 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       ParserTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the word split shared by the indexer and the query parser: positions of words
+ *                  separated by any whitespace, and phrases that span newlines and tabs.
+ */
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+#include "Parser.h"
+#include "Query.h"
+
+TEST_CASE("Parser::for_each_word splits on any whitespace", "[Parser]") {
+    std::vector<std::string> words;
+    Parser::for_each_word("  interest\trate\n\nhike, again \r\n", [&words](std::string &word) {
+        words.push_back(word);
+    });
+    CHECK(words == std::vector<std::string>{"interest", "rate", "hike,", "again"});
+    words.clear();
+    Parser::for_each_word(" \t\n", [&words](std::string &word) { words.push_back(word); });
+    CHECK(words.empty());
+}
+
+TEST_CASE("Phrases match across newlines and tabs", "[Parser]") {
+    //1- Text whose phrase words are separated by a newline, a tab and a blank line
+    IndexConfig config;
+    config.background_merges = false;
+    Index index(config);
+    Article *article = Parser::parse_json_string(
+            R"({"uuid": "p1", "title": "rates", "text": "the bank\nannounced an interest\trate\n\nhike today"})");
+    REQUIRE(article != nullptr);
+    index.add(article);
+    index.flush();
+    IndexSnapshot generation = index.snapshot();
+
+    //2- The query numbers the phrase words like the indexer did
+    CHECK(Query("\"interest rate hike\"").count(*generation) == 1);
+    CHECK(Query("\"bank announced\"").count(*generation) == 1);
+    CHECK(Query("\"announced interest\"~1").count(*generation) == 1);
+    CHECK(Query("\"announced interest\"").count(*generation) == 0);
+    CHECK(Query("\"hike rate\"").count(*generation) == 0);
+}
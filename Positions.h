@@ -0,0 +1,93 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Positions.h
+ * @date:           10-19-2026
+ * @description:    Compressed word positions of one term, stored next to its postings list. The blob holds
+ *                  one entry per posting, in postings order:
+ *                      varint(count) varint(byte length of the deltas) varint(delta)...
+ *                  Positions are word offsets in the article text (stop words and unindexable words
+ *                  count too, so phrases with stop words still line up). The byte length lets a reader
+ *                  skip the documents it does not need without decoding them.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_POSITIONS_H
+#define INC_22S_FINAL_PROJ_POSITIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Positions {
+public:
+    /// \param blob         -> Positions blob of a term
+    /// \param positions    -> Ascending word offsets of the term in the next document
+    /// \description        -> Appends one document entry
+    static void append(std::vector<uint8_t> &blob, const std::vector<uint32_t> &positions) {
+        std::vector<uint8_t> deltas;
+        uint32_t previous = 0;
+        for (uint32_t position: positions) {
+            put_varint(deltas, position - previous);
+            previous = position;
+        }
+        put_varint(blob, positions.size());
+        put_varint(blob, deltas.size());
+        blob.insert(blob.end(), deltas.cbegin(), deltas.cend());
+    }
+
+    static void put_varint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t get_varint(const uint8_t *&data) {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+    }
+
+    /// \description Walks the entries of a blob, one document at a time
+    class Reader {
+    private:
+        const uint8_t *data = nullptr;
+        const uint8_t *end = nullptr;
+
+    public:
+        Reader() = default;
+
+        explicit Reader(const std::vector<uint8_t> &blob) : data(blob.data()), end(blob.data() + blob.size()) {}
+
+        bool done() const { return data == end; }
+
+        /// \return pair        -> First byte and byte length of the current entry, which is then skipped
+        std::pair<const uint8_t *, size_t> next_entry() {
+            const uint8_t *start = data;
+            get_varint(data);
+            size_t length = get_varint(data);
+            data += length;
+            return {start, static_cast<size_t>(data - start)};
+        }
+
+        /// \description        -> Skips the current entry
+        void skip() { next_entry(); }
+
+        /// \param positions    -> Receives the current entry's positions, which is then skipped
+        void read(std::vector<uint32_t> &positions) {
+            positions.resize(get_varint(data));
+            get_varint(data);
+            uint32_t previous = 0;
+            for (uint32_t &position: positions) {
+                position = previous + static_cast<uint32_t>(get_varint(data));
+                previous = position;
+            }
+        }
+    };
+};
+
+#endif //INC_22S_FINAL_PROJ_POSITIONS_H
@@ -1,5 +1,26 @@
 #include "Query.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include <queue>
+#include "Parser.h"
+
+/// \description Query prefix of each Field, e.g. "title:"
+static constexpr const char *FIELD_NAMES[FIELD_COUNT] = {"text", "title"};
+static constexpr uint8_t ALL_FIELDS = (1u << FIELD_COUNT) - 1;
+/// \description Query prefix of each metadata Column, e.g. "site:"
+static constexpr const char *COLUMN_NAMES[COLUMN_COUNT] = {"date", "site", "lang"};
+/// \description Size ratio to the lead of an AND from which an operand gallops instead of merging
+static constexpr size_t GALLOP_RATIO = 8;
+/// \description Consecutive ordinals in a block sampled by estimate_count
+static constexpr size_t SAMPLE_BLOCK = 128;
+/// \description Fewest blocks estimate_count samples; below that it counts exactly
+static constexpr size_t MIN_SAMPLED_BLOCKS = 20;
+
 enum Tokenizer {
     AND,
     OR,
@@ -9,150 +30,1122 @@ enum Tokenizer {
 };
 
 Query::Query(const std::string &query) {
-    std::stringstream qstream(query);
-    std::string token;
+    std::vector<std::string> tokens = split(query);
+    auto token = tokens.cbegin();
+    //A stray closing parenthesis ends the outermost group early; what follows is another alternative
+    std::vector<std::unique_ptr<QueryNode>> groups;
+    while (token != tokens.cend()) {
+        std::unique_ptr<QueryNode> group = parse_group(token, tokens.cend());
+        if (group != nullptr) {
+            groups.push_back(std::move(group));
+        }
+    }
+    if (groups.size() == 1) {
+        root = std::move(groups.front());
+    } else if (!groups.empty()) {
+        root = std::make_unique<QueryNode>(QueryNode::Type::OR);
+        root->children = std::move(groups);
+    }
+    if (root != nullptr) {
+        canonicalize(*root, key);
+    }
+}
+
+void Query::canonicalize(const QueryNode &node, std::string &out) {
+    //Strings carry their length so that no term can be mistaken for syntax
+    auto put = [&out](const std::string &value) { out += std::to_string(value.size()) + ':' + value; };
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            out += 'T' + std::to_string(node.fields) + '/';
+            put(node.term);
+            return;
+        case QueryNode::Type::PHRASE:
+            out += 'P' + std::to_string(node.slop) + '/';
+            for (const auto &term: node.phrase) {
+                out += '@' + std::to_string(term.second) + '/';
+                put(term.first);
+            }
+            return;
+        case QueryNode::Type::ENTITY:
+            out += node.kind == Entity::ORGANIZATION ? 'O' : 'S';
+            out += node.prefix ? '*' : '=';
+            put(node.name);
+            return;
+        case QueryNode::Type::RANGE:
+            out += 'R' + std::to_string(static_cast<int>(node.column));
+            if (node.column == Column::PUBLISHED) {
+                out += '/' + std::to_string(node.low) + '/' + std::to_string(node.high);
+            } else {
+                out += node.prefix ? '*' : '=';
+                put(node.name);
+            }
+            return;
+        case QueryNode::Type::AND:
+            out += '&';
+            break;
+        case QueryNode::Type::OR:
+            out += '|';
+            break;
+        case QueryNode::Type::NOT:
+            out += '!';
+            break;
+    }
+    //AND and OR do not care about operand order: "tesla AND earnings" and "earnings AND tesla" share a key
+    std::vector<std::string> operands;
+    for (const auto &child: node.children) {
+        operands.emplace_back();
+        canonicalize(*child, operands.back());
+    }
+    std::sort(operands.begin(), operands.end());
+    out += '(';
+    for (const std::string &operand: operands) {
+        out += operand;
+    }
+    out += ')';
+}
+
+std::vector<std::string> Query::split(const std::string &query) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < query.size()) {
+        char c = query[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '(' || c == ')') {
+            tokens.emplace_back(1, c);
+            ++i;
+        } else if (c == '"') {
+            //Phrase: up to the closing quote, then an optional ~slop
+            size_t quote = query.find('"', i + 1);
+            size_t stop = quote == std::string::npos ? query.size() : quote + 1;
+            if (stop < query.size() && query[stop] == '~') {
+                ++stop;
+                while (stop < query.size() && std::isdigit(static_cast<unsigned char>(query[stop]))) ++stop;
+            }
+            tokens.push_back(query.substr(i, stop - i));
+            i = stop;
+        } else {
+            size_t stop = i;
+            while (stop < query.size() && !std::isspace(static_cast<unsigned char>(query[stop])) &&
+                   query[stop] != '(' && query[stop] != ')' && query[stop] != '"') {
+                ++stop;
+            }
+            tokens.push_back(query.substr(i, stop - i));
+            i = stop;
+        }
+    }
+    return tokens;
+}
+
+std::unique_ptr<QueryNode> Query::parse_group(std::vector<std::string>::const_iterator &token,
+                                              std::vector<std::string>::const_iterator end) {
     Tokenizer current_tokenizer = OR;
-    while (qstream >> token) {
-        if (token == "AND") current_tokenizer = AND;
-        else if (token == "OR") current_tokenizer = OR;
-        else if (token == "NOT") current_tokenizer = NOT;
-        else if (token == "ORG") current_tokenizer = ORG;
-        else if (token == "PERSON") current_tokenizer = PERSON;
+    std::vector<std::unique_ptr<QueryNode>> required, optional, excluded;
+    //ORG and PERSON words accumulate into one name until the next operator
+    std::string entity_name;
+    auto close_entity = [&]() {
+        if (current_tokenizer != ORG && current_tokenizer != PERSON) {
+            return;
+        }
+        auto entity = std::make_unique<QueryNode>(QueryNode::Type::ENTITY);
+        entity->kind = current_tokenizer == ORG ? Entity::ORGANIZATION : Entity::PERSON;
+        entity->name = EntityDictionary::normalize(entity_name);
+        if (!entity->name.empty() && entity->name.back() == '*') {
+            entity->prefix = true;
+            entity->name.pop_back();
+            entity->name = EntityDictionary::normalize(entity->name);
+        }
+        required.push_back(std::move(entity));
+        entity_name.clear();
+    };
+
+    bool unmatchable = false;
+    while (token != end) {
+        const std::string &word = *token++;
+        if (word == ")") break;
+        Tokenizer next_tokenizer;
+        if (word == "AND") next_tokenizer = AND;
+        else if (word == "OR") next_tokenizer = OR;
+        else if (word == "NOT") next_tokenizer = NOT;
+        else if (word == "ORG") next_tokenizer = ORG;
+        else if (word == "PERSON") next_tokenizer = PERSON;
         else {
+            //A metadata filter restricts the group whatever the operator (NOT excludes it), and ends an entity name
+            std::unique_ptr<QueryNode> filter;
+            if (make_filter(word, filter)) {
+                if (current_tokenizer == ORG || current_tokenizer == PERSON) {
+                    close_entity();
+                    current_tokenizer = AND;
+                }
+                if (filter == nullptr) {
+                    unmatchable |= current_tokenizer != NOT;
+                } else if (current_tokenizer == NOT) {
+                    auto negation = std::make_unique<QueryNode>(QueryNode::Type::NOT);
+                    negation->children.push_back(std::move(filter));
+                    excluded.push_back(std::move(negation));
+                } else {
+                    required.push_back(std::move(filter));
+                }
+                continue;
+            }
+            bool phrase = word.size() > 1 && word.front() == '"';
+            if ((current_tokenizer == ORG || current_tokenizer == PERSON) && word != "(") {
+                size_t quote = phrase ? word.find('"', 1) : std::string::npos;
+                entity_name += ' ' + (phrase ? word.substr(1, quote == std::string::npos ? quote : quote - 1) : word);
+                continue;
+            }
+            std::unique_ptr<QueryNode> operand;
+            if (word == "(") {
+                operand = parse_group(token, end);
+            } else if (phrase) {
+                size_t quote = word.find('"', 1);
+                uint32_t slop = 0;
+                if (quote != std::string::npos && quote + 1 < word.size() && word[quote + 1] == '~') {
+                    slop = static_cast<uint32_t>(std::strtoul(word.c_str() + quote + 2, nullptr, 10));
+                }
+                operand = make_phrase(word.substr(1, quote == std::string::npos ? quote : quote - 1), slop);
+                //Nothing indexed in it: the phrase does not constrain anything
+                if (operand == nullptr) continue;
+            } else {
+                operand = make_term(word);
+            }
+            //Groups that match nothing: a required one empties this group, the others drop out
+            if (operand == nullptr) {
+                unmatchable |= current_tokenizer != OR && current_tokenizer != NOT;
+                continue;
+            }
             switch (current_tokenizer) {
-                case AND:
-                    Porter2Stemmer::stem(token);
-                    this->and_keywords.push_back(token);
-                    break;
                 case OR:
-                    Porter2Stemmer::stem(token);
-                    this->or_keywords.push_back(token);
-                    break;
-                case NOT:
-                    Porter2Stemmer::stem(token);
-                    this->not_words.push_back(token);
+                    optional.push_back(std::move(operand));
                     break;
-                case ORG:
-                    this->organization += ' ' + token;
+                case NOT: {
+                    auto negation = std::make_unique<QueryNode>(QueryNode::Type::NOT);
+                    negation->children.push_back(std::move(operand));
+                    excluded.push_back(std::move(negation));
                     break;
-                case PERSON :
-                    this->person += ' ' + token;
+                }
+                default:
+                    required.push_back(std::move(operand));
                     break;
             }
+            continue;
         }
+        close_entity();
+        current_tokenizer = next_tokenizer;
     }
-    if (!this->organization.empty()) {
-        this->organization.erase(this->organization.begin());
+    close_entity();
+
+    //1- The OR operands form one required disjunction
+    if (optional.size() == 1) {
+        required.push_back(std::move(optional.front()));
+    } else if (!optional.empty()) {
+        auto disjunction = std::make_unique<QueryNode>(QueryNode::Type::OR);
+        disjunction->children = std::move(optional);
+        required.push_back(std::move(disjunction));
+    }
+    //2- Nothing positive (or an unmatchable requirement) matches nothing, whatever is excluded
+    if (required.empty() || unmatchable) {
+        return nullptr;
     }
-    if (!this->person.empty()) {
-        this->person.erase(this->person.begin());
+    if (required.size() == 1 && excluded.empty()) {
+        return std::move(required.front());
     }
+    auto conjunction = std::make_unique<QueryNode>(QueryNode::Type::AND);
+    conjunction->children = std::move(required);
+    for (auto &negation: excluded) {
+        conjunction->children.push_back(std::move(negation));
+    }
+    return conjunction;
 }
 
-std::set<Article *> Query::get_elements(const AvlTree<std::string, Article *> &article_tree,
-                                        const HashMap<std::string, std::set<Article *>> &person_map,
-                                        const HashMap<std::string, std::set<Article *>> &orgs_map) {
+size_t Query::plan(QueryNode &node, const IndexGeneration &generation) const {
+    size_t estimate = 0;
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            for (size_t f = 0; f < FIELD_COUNT; ++f) {
+                if (node.fields & (1u << f)) {
+                    estimate += searched_frequency(generation, node.term, static_cast<Field>(f));
+                }
+            }
+            break;
+        case QueryNode::Type::PHRASE:
+            //No more documents than its rarest term
+            estimate = SIZE_MAX;
+            for (const auto &term: node.phrase) {
+                estimate = std::min(estimate, searched_frequency(generation, term.first, Field::TEXT));
+            }
+            break;
+        case QueryNode::Type::ENTITY:
+            node.entities.clear();
+            if (generation.entities != nullptr) {
+                node.entities = generation.entities->lookup(node.kind, node.name, node.prefix);
+                //Counted in the snapshot's segments, like terms: the dictionary's live counts run ahead of it
+                for (size_t s: searched) {
+                    for (EntityId entity: node.entities) {
+                        estimate += generation.segments[s]->entities().documents(node.kind, entity);
+                    }
+                }
+            }
+            node.bitmaps.reset();
+            if (filter_cache != nullptr) {
+                node.bitmaps = filter_cache->fetch(filter_key(node, generation), generation.number,
+                                                   generation.segments.size(), searched,
+                                                   [&node, &generation](size_t s) {
+                    const Segment &segment = *generation.segments[s];
+                    Bitmap bitmap(segment.doc_count());
+                    std::vector<uint32_t> ordinals;
+                    for (EntityId entity: node.entities) {
+                        segment.entities().postings(node.kind, entity, ordinals);
+                        for (uint32_t local: ordinals) {
+                            bitmap.set(local);
+                        }
+                    }
+                    return bitmap;
+                });
+            }
+            //The bitmaps know the exact count
+            if (node.bitmaps != nullptr) {
+                estimate = 0;
+                for (const Bitmap &bitmap: *node.bitmaps) {
+                    estimate += bitmap.count();
+                }
+            }
+            break;
+        case QueryNode::Type::RANGE: {
+            //Column scans are cheap enough to run at planning time, which gives the exact count
+            auto build = [&node, &generation](size_t s) {
+                const Metadata &metadata = generation.segments[s]->metadata();
+                if (node.column == Column::PUBLISHED) {
+                    return metadata.select(node.column, node.low, node.high);
+                }
+                auto [first, last] = metadata.code_range(node.column, node.name, node.prefix);
+                return metadata.select(node.column, first, last);
+            };
+            node.bitmaps.reset();
+            if (filter_cache != nullptr) {
+                node.bitmaps = filter_cache->fetch(filter_key(node, generation), generation.number,
+                                                   generation.segments.size(), searched, build);
+            }
+            //Uncached, only the searched segments are scanned; the pruned ones get an empty bitmap
+            if (node.bitmaps == nullptr) {
+                auto bitmaps = std::make_shared<FilterBitmaps>(generation.segments.size());
+                for (size_t s: searched) {
+                    (*bitmaps)[s] = build(s);
+                }
+                node.bitmaps = std::move(bitmaps);
+            }
+            for (const Bitmap &bitmap: *node.bitmaps) {
+                estimate += bitmap.count();
+            }
+            break;
+        }
+        case QueryNode::Type::OR:
+            for (auto &child: node.children) {
+                estimate += plan(*child, generation);
+            }
+            estimate = std::min(estimate, generation.doc_count());
+            break;
+        case QueryNode::Type::NOT:
+            estimate = plan(*node.children.front(), generation);
+            break;
+        case QueryNode::Type::AND: {
+            for (auto &child: node.children) {
+                plan(*child, generation);
+            }
+            //1- Rarest operand first, exclusions last: the AND is driven by its smallest operand and only the
+            //   documents that survive every required operand are checked against the exclusions
+            std::stable_sort(node.children.begin(), node.children.end(), [](const auto &a, const auto &b) {
+                bool a_excluded = a->type == QueryNode::Type::NOT, b_excluded = b->type == QueryNode::Type::NOT;
+                return a_excluded != b_excluded ? b_excluded : a->estimate < b->estimate;
+            });
+            //2- An operand much larger than the lead gallops to its candidates; one of similar size merges
+            estimate = node.children.front()->type == QueryNode::Type::NOT ? 0 : node.children.front()->estimate;
+            for (auto &child: node.children) {
+                child->gallop = child->estimate >= GALLOP_RATIO * estimate;
+            }
+            break;
+        }
+    }
+    node.estimate = estimate;
+    return estimate;
+}
+
+size_t Query::prepare(const IndexGeneration &generation) {
+    //1- Date window every match lies in: the intersection of the required date filters, at the root or directly
+    //   under a root AND (excluded ones are under a NOT)
+    int64_t low = INT64_MIN, high = INT64_MAX;
+    auto narrow = [&low, &high](const QueryNode &node) {
+        if (node.type == QueryNode::Type::RANGE && node.column == Column::PUBLISHED) {
+            low = std::max(low, node.low);
+            high = std::min(high, node.high);
+        }
+    };
+    narrow(*root);
+    if (root->type == QueryNode::Type::AND) {
+        for (const auto &child: root->children) {
+            narrow(*child);
+        }
+    }
+    //2- Segments whose publication times cannot fall in it are never searched
+    window_low = low;
+    window_high = high;
+    searched.clear();
+    for (size_t s = 0; s < generation.segments.size(); ++s) {
+        Metadata::Zone bounds = generation.segments[s]->metadata().bounds(Column::PUBLISHED);
+        if (bounds.low <= high && bounds.high >= low) {
+            searched.push_back(s);
+        }
+    }
+    return plan(*root, generation);
+}
+
+std::string Query::filter_key(const QueryNode &node, const IndexGeneration &generation) const {
+    std::string filter;
+    canonicalize(node, filter);
+    if (searched.size() != generation.segments.size()) {
+        filter += " in " + std::to_string(window_low) + ".." + std::to_string(window_high);
+    }
+    return filter;
+}
+
+size_t Query::searched_frequency(const IndexGeneration &generation, const std::string &term, Field field) const {
+    size_t frequency = 0;
+    for (size_t s: searched) {
+        const std::vector<uint32_t> *list = generation.segments[s]->postings(term, field);
+        frequency += list == nullptr ? 0 : list->size();
+    }
+    return frequency;
+}
+
+std::unique_ptr<QueryNode> Query::make_term(std::string token) {
+    auto node = std::make_unique<QueryNode>(QueryNode::Type::TERM);
+    node->fields = ALL_FIELDS;
+    size_t colon = token.find(':');
+    if (colon != std::string::npos) {
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            if (token.compare(0, colon, FIELD_NAMES[f]) == 0) {
+                node->fields = static_cast<uint8_t>(1u << f);
+                token.erase(0, colon + 1);
+                break;
+            }
+        }
+    }
+    Porter2Stemmer::stem(token);
+    node->term = std::move(token);
+    return node;
+}
+
+bool Query::make_filter(const std::string &token, std::unique_ptr<QueryNode> &filter) {
+    size_t colon = token.find(':');
+    size_t column = 0;
+    while (colon != std::string::npos && column < COLUMN_COUNT && token.compare(0, colon, COLUMN_NAMES[column]) != 0) {
+        ++column;
+    }
+    if (colon == std::string::npos || column == COLUMN_COUNT) {
+        return false;
+    }
+    filter = std::make_unique<QueryNode>(QueryNode::Type::RANGE);
+    filter->column = static_cast<Column>(column);
+    std::string value = token.substr(colon + 1);
+    if (filter->column == Column::PUBLISHED) {
+        if (!Metadata::parse_date_range(value, filter->low, filter->high)) {
+            filter.reset();
+        }
+        return true;
+    }
+    //Sites and languages are indexed in lowercase
+    for (char &c: value) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (!value.empty() && value.back() == '*') {
+        filter->prefix = true;
+        value.pop_back();
+    }
+    if (value.empty() && !filter->prefix) {
+        filter.reset();
+        return true;
+    }
+    filter->name = std::move(value);
+    return true;
+}
+
+std::unique_ptr<QueryNode> Query::make_phrase(const std::string &words, uint32_t slop) {
+    auto node = std::make_unique<QueryNode>(QueryNode::Type::PHRASE);
+    node->slop = slop;
+    HashMap<std::string, std::string> stem_cache(50);
+    //Same word split and numbering as the indexer: every word counts, indexed or not
+    uint32_t offset = 0;
+    Parser::for_each_word(words, [&](std::string &word) {
+        if (Parser::normalize_token(word, stem_cache)) {
+            node->phrase.emplace_back(word, offset);
+        }
+        ++offset;
+    });
+    if (node->phrase.empty()) {
+        return nullptr;
+    }
+    if (node->phrase.size() == 1) {
+        auto term = std::make_unique<QueryNode>(QueryNode::Type::TERM);
+        term->term = std::move(node->phrase.front().first);
+        term->fields = static_cast<uint8_t>(1u << static_cast<size_t>(Field::TEXT));
+        return term;
+    }
+    return node;
+}
+
+/// \param iterators    -> Compiled operands
+/// \return DocIterator -> Their union, without the operands that cannot match
+static std::unique_ptr<DocIterator> unite(std::vector<std::unique_ptr<DocIterator>> &&iterators) {
+    iterators.erase(std::remove_if(iterators.begin(), iterators.end(),
+                                   [](const auto &iterator) { return iterator->cost() == 0; }), iterators.end());
+    if (iterators.empty()) {
+        return ListIterator::empty();
+    }
+    if (iterators.size() == 1) {
+        return std::move(iterators.front());
+    }
+    return std::make_unique<UnionIterator>(std::move(iterators));
+}
+
+std::unique_ptr<DocIterator> Query::compile(QueryNode &node, const IndexGeneration &generation, size_t s,
+                                            bool gallop, bool profile) {
+    const Segment &segment = *generation.segments[s];
+    auto build = [&]() -> std::unique_ptr<DocIterator> {
+        std::vector<std::unique_ptr<DocIterator>> children;
+        switch (node.type) {
+            case QueryNode::Type::TERM: {
+                const uint32_t *id = segment.term_id(node.term);
+                for (size_t f = 0; f < FIELD_COUNT && id != nullptr; ++f) {
+                    if (node.fields & (1u << f)) {
+                        const std::vector<uint32_t> &list = segment.postings(*id, static_cast<Field>(f));
+                        children.push_back(std::make_unique<ListIterator>(list, gallop));
+                    }
+                }
+                return unite(std::move(children));
+            }
+            case QueryNode::Type::PHRASE: {
+                std::vector<const std::vector<uint32_t> *> postings;
+                std::vector<const std::vector<uint8_t> *> blobs;
+                std::vector<uint32_t> offsets;
+                for (const auto &term: node.phrase) {
+                    postings.push_back(segment.postings(term.first));
+                    if (postings.back() == nullptr) {
+                        return ListIterator::empty();
+                    }
+                    blobs.push_back(segment.positions(term.first));
+                    offsets.push_back(term.second);
+                    children.push_back(std::make_unique<ListIterator>(*postings.back()));
+                }
+                //Segments indexed without positions only get the document-level check
+                if (!segment.has_positions()) {
+                    return std::make_unique<ConjunctionIterator>(std::move(children));
+                }
+                return std::make_unique<PhraseIterator>(postings, blobs, offsets, node.slop);
+            }
+            case QueryNode::Type::RANGE:
+                return std::make_unique<BitmapIterator>((*node.bitmaps)[s]);
+            case QueryNode::Type::ENTITY: {
+                if (node.bitmaps != nullptr) {
+                    return std::make_unique<BitmapIterator>((*node.bitmaps)[s]);
+                }
+                //A prefix can match several entities: any of them will do
+                for (EntityId entity: node.entities) {
+                    const std::vector<uint8_t> *set = segment.entities().set(node.kind, entity);
+                    if (set != nullptr) {
+                        children.push_back(std::make_unique<DeltaIterator>(*set));
+                    }
+                }
+                return unite(std::move(children));
+            }
+            case QueryNode::Type::OR: {
+                for (const auto &child: node.children) {
+                    children.push_back(compile(*child, generation, s, gallop, profile));
+                }
+                return unite(std::move(children));
+            }
+            case QueryNode::Type::AND: {
+                std::vector<std::unique_ptr<DocIterator>> excluded;
+                for (const auto &child: node.children) {
+                    if (child->type == QueryNode::Type::NOT) {
+                        excluded.push_back(compile(*child->children.front(), generation, s, true, profile));
+                        continue;
+                    }
+                    children.push_back(compile(*child, generation, s, child->gallop, profile));
+                    //A required operand without matches empties the conjunction before anything is walked
+                    if (children.back()->cost() == 0) {
+                        return ListIterator::empty();
+                    }
+                }
+                if (children.empty()) {
+                    return ListIterator::empty();
+                }
+                std::unique_ptr<DocIterator> included = children.size() == 1
+                                                        ? std::move(children.front())
+                                                        : std::make_unique<ConjunctionIterator>(std::move(children));
+                std::unique_ptr<DocIterator> exclusion = unite(std::move(excluded));
+                if (exclusion->cost() == 0) {
+                    return included;
+                }
+                return std::make_unique<ExclusionIterator>(std::move(included), std::move(exclusion));
+            }
+            case QueryNode::Type::NOT:
+                break;
+        }
+        //A NOT outside of an AND has nothing to be subtracted from
+        return ListIterator::empty();
+    };
+    if (!profile) {
+        return build();
+    }
+    return std::make_unique<ProfiledIterator>(build(), node.produced, node.seconds);
+}
+
+void Query::scored_terms(const QueryNode &node, std::vector<std::pair<std::string, uint8_t>> &terms) {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            terms.emplace_back(node.term, node.fields);
+            break;
+        case QueryNode::Type::PHRASE:
+            for (const auto &term: node.phrase) {
+                terms.emplace_back(term.first, static_cast<uint8_t>(1u << static_cast<size_t>(Field::TEXT)));
+            }
+            break;
+        case QueryNode::Type::AND:
+        case QueryNode::Type::OR:
+            for (const auto &child: node.children) {
+                scored_terms(*child, terms);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::vector<std::string> Query::highlighted_terms(Field field) const {
+    std::vector<std::pair<std::string, uint8_t>> scored;
+    if (root != nullptr) {
+        scored_terms(*root, scored);
+    }
+    std::vector<std::string> terms;
+    for (const auto &[term, fields]: scored) {
+        if ((fields & (1u << static_cast<size_t>(field))) &&
+            std::find(terms.cbegin(), terms.cend(), term) == terms.cend()) {
+            terms.push_back(term);
+        }
+    }
+    return terms;
+}
+
+std::vector<uint32_t> Query::match_segment(const IndexGeneration &generation, size_t s, bool profile) const {
+    std::vector<uint32_t> kept;
+    //Short-circuit: the plan already knows nothing matches
+    if (root == nullptr || root->estimate == 0) {
+        return kept;
+    }
+    std::unique_ptr<DocIterator> matches = compile(*root, generation, s, true, profile);
+    for (uint32_t local = matches->next(); local != DocIterator::END; local = matches->next()) {
+        if (!generation.is_deleted(s, local)) {
+            kept.push_back(local);
+        }
+    }
+    return kept;
+}
+
+std::vector<DocId> Query::get_elements(const IndexGeneration &generation, MatchCache *cache) {
     std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
     start = std::chrono::high_resolution_clock::now();
 
-    std::set<Article *> article_set;
-    if (and_keywords.empty()) {
-        for (const std::string &keyword: or_keywords) {
-            auto keyword_vec = article_tree.search(keyword);
-            if (keyword_vec != nullptr) {
-                article_set.insert(keyword_vec->cbegin(), keyword_vec->cend());
+    //A repeat of a query already answered on this generation
+    if (cache != nullptr) {
+        if (auto cached = cache->find(key, generation.number)) {
+            std::chrono::duration<double> time_in_seconds = std::chrono::high_resolution_clock::now() - start;
+            query_processing_time = time_in_seconds.count();
+            return *cached;
+        }
+    }
+
+    std::vector<DocId> matches;
+    if (root != nullptr) {
+        prepare(generation);
+        for (size_t s: searched) {
+            for (uint32_t local: match_segment(generation, s)) {
+                matches.push_back(generation.segments[s]->global_id(local));
             }
         }
     }
-    bool first_pass = true;
-    for (const std::string &keyword: and_keywords) {
-        auto keyword_vec = article_tree.search(keyword);
-        if (keyword_vec != nullptr) {
-            if (first_pass) {
-                article_set = {keyword_vec->cbegin(), keyword_vec->cend()};
-                first_pass = false;
+    //Merged segments may cover interleaved id ranges
+    if (!std::is_sorted(matches.cbegin(), matches.cend())) {
+        std::sort(matches.begin(), matches.end());
+    }
+    if (cache != nullptr) {
+        cache->insert(key, generation.number, std::vector<DocId>(matches));
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    //calculate the duration between "start" and "end"
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+    return matches;
+}
+
+/// \return string      -> "value" written exactly (hexadecimal float), for cache keys
+static std::string exact(double value) {
+    std::stringstream out;
+    out << std::hexfloat << value;
+    return out.str();
+}
+
+/// \return bool        -> Whether "a" ranks before "b": higher score first, then ascending id
+static bool ranks_before(const ScoredDoc &a, const ScoredDoc &b) {
+    return a.score > b.score || (a.score == b.score && a.id < b.id);
+}
+
+std::string Query::ranking_key() const {
+    std::string ranked_key = key;
+    for (double boost: boosts) {
+        ranked_key += ' ' + exact(boost);
+    }
+    return ranked_key;
+}
+
+void Query::score(const IndexGeneration &generation, const std::function<void(const ScoredDoc &)> &visit) {
+    if (root == nullptr) {
+        return;
+    }
+    //1- Scored terms: the positive keywords in their fields, and the phrase words in the text
+    //   (excluded ones do not count)
+    std::vector<std::pair<std::string, uint8_t>> scored;
+    scored_terms(*root, scored);
+    if (prepare(generation) == 0) {
+        return;
+    }
+
+    //2- Weight of each (term, field): its boost times its idf over the generation. Document frequencies
+    //   include deleted documents that are not compacted away yet
+    double documents = static_cast<double>(generation.doc_count());
+    std::vector<std::array<double, FIELD_COUNT>> weights(scored.size());
+    for (size_t k = 0; k < scored.size(); ++k) {
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            if (!(scored[k].second & (1u << f))) {
+                weights[k][f] = 0;
                 continue;
             }
-            std::set<Article *> intersection;
-            std::set<Article *> temp_set(keyword_vec->cbegin(), keyword_vec->cend());
-            std::set_intersection(article_set.cbegin(), article_set.cend(), temp_set.cbegin(), temp_set.cend(),
-                                  std::inserter(intersection, intersection.cbegin()));
-            article_set = intersection;
-        } else {
-            return {};
+            size_t frequency = generation.document_frequency(scored[k].first, static_cast<Field>(f));
+            weights[k][f] = boosts[f] * std::log(1 + documents / (1 + static_cast<double>(frequency)));
         }
     }
-    std::set<Article *> filtered_set;
-    if (!organization.empty()) {
-        const auto org_set = orgs_map.find(organization);
-        if (org_set != nullptr) {
-            for (Article *article: article_set) {
-                if (org_set->find(article) != org_set->end()) {
-                    filtered_set.insert(article);
+
+    //3- Score each match as it comes, every (term, field) postings list advancing alongside the matches
+    for (size_t s: searched) {
+        const Segment &segment = *generation.segments[s];
+        std::vector<std::pair<std::unique_ptr<DocIterator>, double>> lists;
+        for (size_t k = 0; k < scored.size(); ++k) {
+            const uint32_t *id = segment.term_id(scored[k].first);
+            for (size_t f = 0; f < FIELD_COUNT && id != nullptr; ++f) {
+                const std::vector<uint32_t> &list = segment.postings(*id, static_cast<Field>(f));
+                if (weights[k][f] != 0 && !list.empty()) {
+                    lists.emplace_back(std::make_unique<ListIterator>(list), weights[k][f]);
                 }
             }
         }
-    }
-    if (!person.empty()) {
-        const auto person_set = orgs_map.find(person);
-        if (person_set != nullptr) {
-            for (Article *article: article_set) {
-                if (person_set->find(article) != person_set->end()) {
-                    filtered_set.insert(article);
+        std::unique_ptr<DocIterator> matches = compile(*root, generation, s, true, false);
+        for (uint32_t local = matches->next(); local != DocIterator::END; local = matches->next()) {
+            if (generation.is_deleted(s, local)) {
+                continue;
+            }
+            double document_score = 0;
+            for (auto &list: lists) {
+                if (list.first->advance_to(local) == local) {
+                    document_score += list.second;
                 }
             }
+            visit({segment.global_id(local), document_score});
         }
     }
-    filtered_set = {};
-    for (Article *article: article_set) {
-        if (!organization.empty() &&
-            std::find(article->organizations.cbegin(), article->organizations.cend(), organization) ==
-            article->organizations.cend()) {
-            continue;
+}
+
+std::vector<ScoredDoc> Query::get_ranked_elements(const IndexGeneration &generation, RankedCache *cache) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    //Scores depend on the boosts too
+    std::string ranked_key = ranking_key();
+    if (cache != nullptr) {
+        if (auto cached = cache->find(ranked_key, generation.number)) {
+            std::chrono::duration<double> time_in_seconds = std::chrono::high_resolution_clock::now() - start;
+            query_processing_time = time_in_seconds.count();
+            return *cached;
         }
-        if (!person.empty() &&
-            std::find(article->persons.cbegin(), article->persons.cend(), person) == article->persons.cend()) {
-            continue;
+    }
+
+    std::vector<ScoredDoc> ranked;
+    score(generation, [&ranked](const ScoredDoc &hit) { ranked.push_back(hit); });
+    std::sort(ranked.begin(), ranked.end(), ranks_before);
+    if (cache != nullptr) {
+        cache->insert(ranked_key, generation.number, std::vector<ScoredDoc>(ranked));
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+    return ranked;
+}
+
+ResultPage Query::get_page(const IndexGeneration &generation, size_t k, const ScoredDoc *after, PageCache *cache) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    std::string page_key = ranking_key() + " top " + std::to_string(k);
+    if (after != nullptr) {
+        page_key += " after " + exact(after->score) + ' ' + std::to_string(after->id);
+    }
+    if (cache != nullptr) {
+        if (auto cached = cache->find(page_key, generation.number)) {
+            std::chrono::duration<double> time_in_seconds = std::chrono::high_resolution_clock::now() - start;
+            query_processing_time = time_in_seconds.count();
+            return *cached;
         }
-        filtered_set.insert(article);
     }
 
-    std::set<Article *> not_filtered;
+    //Keep the k best hits ranking after the cursor; the worst of them sits on top of the heap
+    ResultPage page;
+    size_t remaining = 0;
+    std::priority_queue<ScoredDoc, std::vector<ScoredDoc>, decltype(&ranks_before)> best(ranks_before);
+    score(generation, [&](const ScoredDoc &hit) {
+        ++page.total;
+        if (after != nullptr && !ranks_before(*after, hit)) {
+            return;
+        }
+        ++remaining;
+        if (best.size() < k) {
+            best.push(hit);
+        } else if (k != 0 && ranks_before(hit, best.top())) {
+            best.pop();
+            best.push(hit);
+        }
+    });
+    page.more = remaining > k;
+    page.hits.resize(best.size());
+    for (size_t i = best.size(); i-- > 0;) {
+        page.hits[i] = best.top();
+        best.pop();
+    }
+    if (cache != nullptr) {
+        cache->insert(page_key, generation.number, ResultPage(page));
+    }
 
-    for (std::string &tok: not_words) {
-        auto vec = article_tree.search(tok);
-        if (vec != nullptr) {
-            for (auto n: *vec) {
-                auto find = filtered_set.find(n);
-                if (find != filtered_set.end()) {
-                    filtered_set.erase(find);
-                }
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+    return page;
+}
+
+std::array<FacetCounts, ENTITY_KIND_COUNT> Query::facets(const IndexGeneration &generation, size_t n,
+                                                         size_t sample_limit) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    std::array<FacetCounts, ENTITY_KIND_COUNT> facets;
+    if (root == nullptr || generation.entities == nullptr) {
+        return facets;
+    }
+    //1- Size of the result set, counted without collecting it (postings lengths and bitmaps where possible)
+    size_t total = 0;
+    if (prepare(generation) != 0) {
+        for (size_t s: searched) {
+            total += count_segment(generation, s);
+        }
+    }
+
+    //2- Stream the matches of every segment into one counter per kind, which reads their tags from the
+    //   segment's forward column
+    std::vector<FacetCounter> counters;
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        auto kind = static_cast<Entity>(k);
+        counters.emplace_back(kind, generation.entities->id_count(kind), total, sample_limit);
+    }
+    for (size_t s: searched) {
+        if (total == 0) {
+            break;
+        }
+        const EntityIndex &entities = generation.segments[s]->entities();
+        std::unique_ptr<DocIterator> matches = compile(*root, generation, s, true, false);
+        for (uint32_t local = matches->next(); local != DocIterator::END; local = matches->next()) {
+            if (generation.is_deleted(s, local)) {
+                continue;
+            }
+            for (FacetCounter &counter: counters) {
+                counter.add(entities, local);
             }
         }
     }
+    for (size_t k = 0; k < ENTITY_KIND_COUNT; ++k) {
+        facets[k] = counters[k].top(n, *generation.entities);
+    }
 
     end = std::chrono::high_resolution_clock::now();
-    //calculate the duration between "start" and "end"
     std::chrono::duration<double> time_in_seconds = end - start;
     query_processing_time = time_in_seconds.count();
-    return filtered_set;
+    return facets;
 }
 
-// This does something
-int Query::frequency(const std::vector<std::string> &tokens) {
-    int weight = 0;
-    for (const std::string &tok: tokens) {
-        for (const std::string &str: and_keywords) {
-            if (abs(strcmp(tok.c_str(), str.c_str())) < 10) {
-                ++weight;
+size_t Query::count_segment(const IndexGeneration &generation, size_t s) const {
+    const Segment &segment = *generation.segments[s];
+    const Bitmap *deleted = generation.deletions[s].get();
+    //1- A cached filter or a metadata filter: popcount of its bitmap, tombstones masked out
+    if ((root->type == QueryNode::Type::ENTITY || root->type == QueryNode::Type::RANGE) && root->bitmaps != nullptr) {
+        return (*root->bitmaps)[s].count_and_not(deleted);
+    }
+    //2- A term found in a single field: the length of its postings, less the deleted ones
+    if (root->type == QueryNode::Type::TERM) {
+        const uint32_t *id = segment.term_id(root->term);
+        if (id == nullptr) {
+            return 0;
+        }
+        const std::vector<uint32_t> *list = nullptr;
+        size_t lists = 0;
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            const std::vector<uint32_t> &field_list = segment.postings(*id, static_cast<Field>(f));
+            if ((root->fields & (1u << f)) && !field_list.empty()) {
+                list = &field_list;
+                ++lists;
+            }
+        }
+        if (lists == 0) {
+            return 0;
+        }
+        if (lists == 1) {
+            if (deleted == nullptr) {
+                return list->size();
+            }
+            size_t live = 0;
+            for (uint32_t local: *list) {
+                live += !deleted->test(local);
+            }
+            return live;
+        }
+    }
+    //3- Anything else: walk the iterators without keeping what they find
+    size_t live = 0;
+    std::unique_ptr<DocIterator> matches = compile(*root, generation, s, true, false);
+    for (uint32_t local = matches->next(); local != DocIterator::END; local = matches->next()) {
+        live += !generation.is_deleted(s, local);
+    }
+    return live;
+}
+
+size_t Query::count(const IndexGeneration &generation) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    size_t total = 0;
+    if (root != nullptr && prepare(generation) != 0) {
+        for (size_t s: searched) {
+            total += count_segment(generation, s);
+        }
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+    return total;
+}
+
+CountEstimate Query::estimate_count(const IndexGeneration &generation, double sample_rate) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    if (root == nullptr) {
+        return {0, 0, 0, true};
+    }
+    size_t planned = prepare(generation);
+    size_t blocks = 0;
+    size_t ordinals = 0;
+    for (size_t s: searched) {
+        blocks += (generation.segments[s]->doc_count() + SAMPLE_BLOCK - 1) / SAMPLE_BLOCK;
+        ordinals += generation.segments[s]->doc_count();
+    }
+    //1- One block in every "stride". Too few blocks to sample from (or nothing to skip): count exactly
+    size_t stride = sample_rate <= 0 ? blocks : static_cast<size_t>(std::llround(1 / std::min(sample_rate, 1.0)));
+    if (planned != 0 && (stride <= 1 || blocks < MIN_SAMPLED_BLOCKS * stride)) {
+        size_t exact = 0;
+        for (size_t s: searched) {
+            exact += count_segment(generation, s);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> time_in_seconds = end - start;
+        query_processing_time = time_in_seconds.count();
+        return {exact, exact, exact, true};
+    }
+    if (planned == 0) {
+        end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> time_in_seconds = end - start;
+        query_processing_time = time_in_seconds.count();
+        return {0, 0, 0, true};
+    }
+    //The phase depends on the query and generation only, so asking again gives the same answer
+    size_t phase = std::hash<std::string>()(key) ^ generation.number;
+    phase %= stride;
+
+    //2- Live matches of each sampled block. Iterators skip straight to the blocks with advance_to
+    std::vector<std::pair<double, double>> samples;
+    size_t found = 0;
+    size_t block = 0;
+    for (size_t s: searched) {
+        std::unique_ptr<DocIterator> matches;
+        size_t documents = generation.segments[s]->doc_count();
+        for (size_t first = 0; first < documents; first += SAMPLE_BLOCK, ++block) {
+            if (block % stride != phase) {
+                continue;
+            }
+            if (matches == nullptr) {
+                matches = compile(*root, generation, s, true, false);
             }
+            size_t last = std::min(first + SAMPLE_BLOCK, documents);
+            size_t hits = 0;
+            for (uint32_t local = matches->advance_to(static_cast<uint32_t>(first)); local < last;
+                 local = matches->next()) {
+                hits += !generation.is_deleted(s, local);
+            }
+            found += hits;
+            samples.emplace_back(static_cast<double>(hits), static_cast<double>(last - first));
         }
-        for (const std::string &str: or_keywords) {
-            if (abs(strcmp(tok.c_str(), str.c_str())) < 10) {
-                ++weight;
+    }
+
+    //3- Ratio estimate over all ordinals, and its 95% interval (blocks treated as a simple random sample).
+    //   The matches seen are a floor, the live documents a ceiling
+    double matched = 0, sampled = 0;
+    for (const auto &sample: samples) {
+        matched += sample.first;
+        sampled += sample.second;
+    }
+    double ratio = matched / sampled;
+    double variance = 0;
+    for (const auto &sample: samples) {
+        double residual = sample.first - ratio * sample.second;
+        variance += residual * residual;
+    }
+    double m = static_cast<double>(samples.size()), total_blocks = static_cast<double>(blocks);
+    variance = total_blocks * total_blocks * (1 - m / total_blocks) * variance / (m - 1) / m;
+    double total = ratio * static_cast<double>(ordinals);
+    double bound = 1.96 * std::sqrt(variance);
+    double floor = static_cast<double>(found);
+    double ceiling = std::max(floor, static_cast<double>(generation.doc_count()));
+    CountEstimate estimate{};
+    estimate.count = static_cast<size_t>(std::llround(std::clamp(total, floor, ceiling)));
+    estimate.low = static_cast<size_t>(std::llround(std::clamp(total - bound, floor, ceiling)));
+    estimate.high = static_cast<size_t>(std::llround(std::clamp(total + bound, floor, ceiling)));
+    estimate.exact = false;
+
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+    return estimate;
+}
+
+void Query::describe(const QueryNode &node, size_t depth, const char *step, std::ostream &out) {
+    std::stringstream operation;
+    operation << std::string(2 * depth, ' ');
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            operation << "TERM " << node.term;
+            for (size_t f = 0; f < FIELD_COUNT && node.fields != ALL_FIELDS; ++f) {
+                if (node.fields & (1u << f)) operation << " [" << FIELD_NAMES[f] << ']';
+            }
+            break;
+        case QueryNode::Type::PHRASE:
+            operation << "PHRASE \"";
+            for (size_t t = 0; t < node.phrase.size(); ++t) {
+                operation << (t == 0 ? "" : " ") << node.phrase[t].first;
             }
+            operation << '"';
+            if (node.slop != 0) operation << '~' << node.slop;
+            break;
+        case QueryNode::Type::ENTITY:
+            operation << (node.kind == Entity::ORGANIZATION ? "ORG " : "PERSON ") << node.name
+                      << (node.prefix ? "*" : "") << " (" << node.entities.size() << " entities"
+                      << (node.bitmaps != nullptr ? ", cached bitmap)" : ")");
+            break;
+        case QueryNode::Type::RANGE:
+            if (node.column == Column::PUBLISHED) {
+                operation << "DATE " << (node.low <= UNKNOWN_DATE + 1 ? "" : Metadata::format_date(node.low)) << ".."
+                          << (node.high == INT64_MAX ? "" : Metadata::format_date(node.high));
+            } else {
+                operation << (node.column == Column::SITE ? "SITE " : "LANG ") << node.name
+                          << (node.prefix ? "*" : "");
+            }
+            operation << " (column scan)";
+            break;
+        case QueryNode::Type::AND:
+            operation << "AND";
+            break;
+        case QueryNode::Type::OR:
+            operation << "OR";
+            break;
+        case QueryNode::Type::NOT:
+            operation << "NOT";
+            break;
+    }
+    out << std::left << std::setw(48) << operation.str() << std::right
+        << " est " << std::setw(8) << node.estimate;
+    //NOT nodes are evaluated through their operand
+    if (node.type != QueryNode::Type::NOT) {
+        out << "  actual " << std::setw(8) << node.produced
+            << "  " << std::fixed << std::setprecision(3) << std::setw(9) << node.seconds * 1000 << " ms";
+        out.unsetf(std::ios::fixed);
+    }
+    if (step != nullptr) {
+        out << "  " << step;
+    }
+    out << '\n';
+    for (const auto &child: node.children) {
+        const char *child_step = nullptr;
+        if (node.type == QueryNode::Type::AND && child->type != QueryNode::Type::NOT) {
+            child_step = child == node.children.front() ? "lead" : child->gallop ? "gallop" : "merge";
         }
+        describe(*child, depth + 1, child_step, out);
     }
-    return weight;
 }
 
+std::string Query::explain(const IndexGeneration &generation) {
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    start = std::chrono::high_resolution_clock::now();
+
+    std::stringstream out;
+    if (root == nullptr) {
+        out << "Nothing to search for: the query matches no document\n";
+        return out.str();
+    }
+    //1- Plan, then evaluate with every node counting what it produces
+    prepare(generation);
+    std::vector<QueryNode *> pending{root.get()};
+    while (!pending.empty()) {
+        QueryNode *node = pending.back();
+        pending.pop_back();
+        node->produced = 0;
+        node->seconds = 0;
+        for (auto &child: node->children) {
+            pending.push_back(child.get());
+        }
+    }
+    size_t matches = 0;
+    for (size_t s: searched) {
+        matches += match_segment(generation, s, true).size();
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time_in_seconds = end - start;
+    query_processing_time = time_in_seconds.count();
+
+    //2- The plan, operands in evaluation order. "actual" counts what each node handed to its parent, which for
+    //   an AND operand is only what the lead asked it to confirm
+    out << "Plan over " << generation.segments.size() << " segment(s), " << generation.doc_count()
+        << " document(s)";
+    if (searched.size() != generation.segments.size()) {
+        out << ", " << generation.segments.size() - searched.size() << " pruned by date";
+    }
+    out << (root->estimate == 0 ? ", short-circuited: a required term is missing" : "") << '\n';
+    describe(*root, 0, nullptr, out);
+    out << matches << " live match(es) in " << query_processing_time * 1000 << " ms\n";
+    return out.str();
+}
@@ -3,48 +3,268 @@
  * @filename:       Query.h
  * @date:           04-06-2022
  * @description:    Implementation of our boolean query processor
+ *                  The query is parsed into a tree of QueryNodes. AND, OR and NOT switch how the operands
+ *                  that follow them combine (OR until one is given); in one group every AND operand is
+ *                  required, at least one OR operand is required when there are any, and NOT operands are
+ *                  excluded. Parentheses open a nested group with the same rules:
+ *                  "AND earnings (OR snap facebook) NOT (AND stock split)".
+ *                  A quoted group of words is a phrase: "interest rate hike" matches the words next to each
+ *                  other, in order; "interest rate"~3 allows up to 3 other words between them (proximity).
+ *                  A keyword matches in any field unless it is scoped: "title:tesla" only reads the title
+ *                  postings, "text:tesla" only the text ones. Phrases are matched in the text.
+ *                  ORG and PERSON filter on the segments' entity postings (names match case-insensitively,
+ *                  and a trailing * matches every entity starting with the name: "ORG goldman*"); a query
+ *                  made only of them returns every article tagged with the entities.
+ *                  Metadata filters are always required (or excluded, after NOT): "date:2018-03" (a day, month or
+ *                  year, or a range "2018-03-01..2018-03-15" open on either side), "site:reuters.com" and
+ *                  "lang:english". They are evaluated by scanning the segments' Metadata columns into bitmaps:
+ *                  "tariffs site:reuters.com date:2018-03".
+ *                  A required date filter also prunes segments: those whose publication times all fall outside
+ *                  it (see Metadata::bounds) are left out of the search before any of their postings is read,
+ *                  which makes recent-window queries on a time-partitioned index (IndexConfig::partitioning)
+ *                  cost in proportion to the window.
+ *                  Each segment compiles the tree into DocIterators and walks it doc-at-a-time, so
+ *                  conjunctions only visit the candidates of their rarest clause.
+ *                  Ranked results score each document by the idf of the query terms it contains, weighted
+ *                  by the boost of the field they were found in.
+ *                  facets() counts the organizations and persons the matches are tagged with (see Facets.h).
  */
 
 #ifndef INC_22S_FINAL_PROJ_QUERY_H
 #define INC_22S_FINAL_PROJ_QUERY_H
 
+#include <array>
+#include <memory>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <set>
 #include "Article.h"
-#include "AvlTree.h"
+#include "DocIterator.h"
+#include "Facets.h"
+#include "Index.h"
+#include "QueryNode.h"
+#include "ResultCache.h"
 #include "porter2_stemmer.h"
-#include "HashMap.h"
 #include <unordered_set>
 #include <chrono>
+#include <functional>
+
+struct ScoredDoc {
+    DocId id;
+    double score;
+};
+
+/// \description Approximate number of matches: "count" is the estimate, and the true count lies in [low, high]
+///              with 95% confidence (always, when "exact")
+struct CountEstimate {
+    size_t count;
+    size_t low;
+    size_t high;
+    bool exact;
+};
+
+/// \description One page of ranked results
+struct ResultPage {
+    /// \description At most k hits, best first
+    std::vector<ScoredDoc> hits;
+    /// \description Number of matches, over all pages
+    size_t total = 0;
+    /// \description Whether more hits follow; pass hits.back() as the cursor of the next page
+    bool more = false;
+};
+
+using MatchCache = ResultCache<std::vector<DocId>>;
+using RankedCache = ResultCache<std::vector<ScoredDoc>>;
+using PageCache = ResultCache<ResultPage>;
 
 class Query {
 
 private:
-    std::vector<std::string> and_keywords;
-    std::vector<std::string> or_keywords;
-    std::vector<std::string> not_words;
-    std::string organization;
-    std::string person;
+    /// \description Parsed query; nullptr when nothing can match
+    std::unique_ptr<QueryNode> root;
+    /// \description Canonical form of "root"
+    std::string key;
+    FilterCache *filter_cache = nullptr;
+    std::array<double, FIELD_COUNT> boosts{1.0, 3.0};
+    /// \description Positions of the segments the last prepare() kept: those not pruned by date
+    std::vector<size_t> searched;
+    /// \description Date window the last prepare() pruned the segments with
+    int64_t window_low = INT64_MIN;
+    int64_t window_high = INT64_MAX;
 
     double query_processing_time = 0;
+
+    /// \param query        -> Query text
+    /// \return vector      -> Its words; parentheses are tokens of their own and a quoted phrase, with its ~slop,
+    ///                     is a single token
+    static std::vector<std::string> split(const std::string &query);
+
+    /// \param token        -> Next token to read; left after the group's closing parenthesis
+    /// \param end          -> End of the tokens
+    /// \return QueryNode   -> The group's tree, or nullptr if it cannot match anything
+    static std::unique_ptr<QueryNode> parse_group(std::vector<std::string>::const_iterator &token,
+                                                  std::vector<std::string>::const_iterator end);
+
+    /// \param node         -> Subtree to write
+    /// \param out          -> Receives its canonical form: stemmed terms, resolved fields, and the operands of
+    ///                     AND and OR in sorted order, so that equivalent queries get the same string
+    static void canonicalize(const QueryNode &node, std::string &out);
+
+    /// \param token        -> Query word, possibly prefixed by a field name ("title:rates")
+    /// \return QueryNode   -> TERM node with the stemmed term and the fields it is scoped to
+    static std::unique_ptr<QueryNode> make_term(std::string token);
+
+    /// \param token        -> Query word
+    /// \param filter       -> Receives the RANGE node of a metadata filter: "date:2018-03" (see
+    ///                     Metadata::parse_date_range), "site:reuters.com", "lang:english" (a trailing * matches
+    ///                     every value starting with it). nullptr when the value is malformed
+    /// \return bool        -> Whether "token" is a metadata filter
+    static bool make_filter(const std::string &token, std::unique_ptr<QueryNode> &filter);
+
+    /// \param words        -> Words of the phrase, as typed
+    /// \param slop         -> Extra words allowed between them
+    /// \return QueryNode   -> PHRASE node in index terms (a TERM node for one term), or nullptr when no word is
+    ///                     indexed
+    static std::unique_ptr<QueryNode> make_phrase(const std::string &words, uint32_t slop);
+
+    /// \param node         -> Subtree to plan for "generation"
+    /// \param generation   -> Snapshot of the index to search
+    /// \return size_t      -> Estimated number of documents matching "node" (also stored in it). ENTITY nodes get
+    ///                     the ids their name matches, the operands of an AND are sorted by estimate (rarest
+    ///                     first, exclusions last) and each picks how it skips to the lead's candidates. Popular
+    ///                     ORG/PERSON filters get their bitmaps from the filter cache
+    size_t plan(QueryNode &node, const IndexGeneration &generation) const;
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \return size_t      -> Estimated number of matches. Keeps in "searched" the segments whose publication
+    ///                     times overlap every required date filter of the query, then plans the query for them
+    size_t prepare(const IndexGeneration &generation);
+
+    /// \param node         -> ENTITY or RANGE node
+    /// \param generation   -> Snapshot of the index to search, "searched" prepared for it
+    /// \return string      -> Filter cache key of the node's bitmaps: its canonical form, and the date window when
+    ///                     segments were pruned, since only the searched segments get a bitmap
+    std::string filter_key(const QueryNode &node, const IndexGeneration &generation) const;
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \param term         -> Stemmed term
+    /// \param field        -> Field to count in
+    /// \return size_t      -> Number of documents of the searched segments whose "field" contains "term"
+    size_t searched_frequency(const IndexGeneration &generation, const std::string &term, Field field) const;
+
+    /// \param node         -> Planned subtree to compile
+    /// \param generation   -> Snapshot of the index the subtree was planned for
+    /// \param s            -> Segment of "generation" to search
+    /// \param gallop       -> How postings lists of the subtree skip ahead (see QueryNode::gallop)
+    /// \param profile      -> Count what every node produces and the time spent in it (EXPLAIN)
+    /// \return DocIterator -> Iterator over the local ordinals of the documents matching "node", deleted or not
+    static std::unique_ptr<DocIterator> compile(QueryNode &node, const IndexGeneration &generation, size_t s,
+                                                bool gallop, bool profile);
+
+    /// \param node         -> Subtree to collect from
+    /// \param terms        -> Receives the terms and fields of its positive TERM and PHRASE nodes
+    static void scored_terms(const QueryNode &node, std::vector<std::pair<std::string, uint8_t>> &terms);
+
+    /// \return string      -> Cache key of the query's rankings: its canonical form and the boosts
+    std::string ranking_key() const;
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \param visit        -> Called with every live match and its score, in no particular order. Documents are
+    ///                     scored one at a time as the iterators produce them; nothing is collected
+    void score(const IndexGeneration &generation, const std::function<void(const ScoredDoc &)> &visit);
+
+    /// \param generation   -> Snapshot of the index to search, the query planned for it
+    /// \param s            -> Segment of "generation" to count in
+    /// \return size_t      -> Number of live matching documents of segment "s". A lone term or cached filter is
+    ///                     counted from its postings length or bitmap without walking an iterator
+    size_t count_segment(const IndexGeneration &generation, size_t s) const;
+
+    /// \param node         -> Planned subtree
+    /// \param depth        -> Nesting level of "node"
+    /// \param step         -> How "node" is intersected when it is an operand of an AND ("lead", "merge" or
+    ///                     "gallop"), or nullptr
+    /// \param out          -> Receives one line per node: the operation, estimated and produced documents, time
+    static void describe(const QueryNode &node, size_t depth, const char *step, std::ostream &out);
+
+    /// \param generation   -> Snapshot of the index to search, the query planned for it
+    /// \param s            -> Segment of "generation" to evaluate
+    /// \param profile      -> Count what every node produces (EXPLAIN)
+    /// \return vector      -> Ascending local ordinals of the live matching documents of segment "s"
+    std::vector<uint32_t> match_segment(const IndexGeneration &generation, size_t s, bool profile = false) const;
 public:
     explicit Query(const std::string &query);
 
-    std::set<Article *> get_elements(const AvlTree<std::string, Article *> &article_tree,
-                                     const HashMap <std::string, std::set<Article *>> &person_map,
-                                     const HashMap <std::string, std::set<Article *>> &orgs_map);
+    /// \return string      -> Canonical form of the parsed query (empty when it matches nothing): the key of
+    ///                     its results in a ResultCache
+    const std::string &canonical() const { return key; }
 
-    double get_query_processing_time() { return query_processing_time; }
+    /// \param generation   -> Snapshot of the index to search
+    /// \param cache        -> Results of earlier queries, or nullptr; the result is looked up in it first and
+    ///                     stored in it when it has to be computed
+    /// \return vector      -> Ids of the matching articles, ascending
+    /// \description        -> Evaluates the query on every segment of "generation" and concatenates the hits
+    std::vector<DocId> get_elements(const IndexGeneration &generation, MatchCache *cache = nullptr);
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \param cache        -> Rankings of earlier queries, or nullptr. Entries are per boost setting
+    /// \return vector      -> The matching articles with their score, best first (ties by ascending id).
+    ///                     score = sum over the positive query terms, and each field they are searched in, of
+    ///                     boost(field) * log(1 + N / (1 + df(term, field))) when the document's field has the term
+    std::vector<ScoredDoc> get_ranked_elements(const IndexGeneration &generation, RankedCache *cache = nullptr);
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \return size_t      -> Number of matching articles, without collecting, ranking or reading any of them
+    size_t count(const IndexGeneration &generation);
 
-    int frequency(const std::vector<std::string> &tokens);
+    /// \param generation   -> Snapshot of the index to search
+    /// \param sample_rate  -> Fraction of the documents to evaluate the query on
+    /// \return CountEstimate -> Number of matching articles, estimated from evenly spaced blocks of documents
+    ///                     covering "sample_rate" of each segment, with a 95% confidence interval. Small
+    ///                     generations, or a rate of 1, are counted exactly
+    CountEstimate estimate_count(const IndexGeneration &generation, double sample_rate = 0.05);
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \return string      -> EXPLAIN: the plan chosen for "generation", one node per line with its estimated and
+    ///                     actual (produced) document counts and the time spent in it, children included. The
+    ///                     query is evaluated to measure them
+    std::string explain(const IndexGeneration &generation);
+
+    /// \param field        -> Field to weight
+    /// \param boost        -> Multiplier of the field's contribution to scores (text: 1, title: 3 by default)
+    void set_boost(Field field, double boost) { boosts[static_cast<size_t>(field)] = boost; }
+
+    /// \param generation   -> Snapshot of the index to search. Keep it (IndexSnapshot::retain) while paging
+    /// \param k            -> Page size
+    /// \param after        -> Last hit of the previous page, or nullptr for the first page
+    /// \param cache        -> Pages of earlier queries, or nullptr
+    /// \return ResultPage  -> The k best hits ranking after "after" (same order as get_ranked_elements). They are
+    ///                     selected with a k-sized heap while scoring, so memory does not grow with the matches
+    ResultPage get_page(const IndexGeneration &generation, size_t k, const ScoredDoc *after = nullptr,
+                        PageCache *cache = nullptr);
+
+    /// \param generation   -> Snapshot of the index to search
+    /// \param n            -> Number of entities wanted of each kind
+    /// \param sample_limit -> Most matches whose tags are counted; larger result sets are sampled (0 never samples)
+    /// \return array       -> For each kind of entity, the n that most matching articles are tagged with
+    std::array<FacetCounts, ENTITY_KIND_COUNT> facets(const IndexGeneration &generation, size_t n,
+                                                      size_t sample_limit = FacetCounter::DEFAULT_SAMPLE_LIMIT);
+
+    /// \param field        -> Field the terms are looked for in
+    /// \return vector      -> Distinct index terms of the query's positive words and phrases searched in "field":
+    ///                     what a snippet of that field highlights
+    std::vector<std::string> highlighted_terms(Field field) const;
+
+    /// \param cache        -> Where ORG/PERSON filters keep their bitmaps across queries, or nullptr
+    void set_filter_cache(FilterCache *cache) { filter_cache = cache; }
+
+    double get_query_processing_time() { return query_processing_time; }
 };
 
 struct ArticlePair {
-    Article *article;
-    int weight;
+    const Article *article;
+    double weight;
     bool operator<(const ArticlePair &pair) {
         return weight < pair.weight;
     }
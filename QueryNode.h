@@ -0,0 +1,83 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       QueryNode.h
+ * @date:           10-19-2026
+ * @description:    Abstract syntax tree of a boolean query. Query parses the query text into a tree of
+ *                  QueryNodes and compiles it, segment by segment, into a tree of DocIterators.
+ *                      - TERM: an index term, searched in one or more fields
+ *                      - PHRASE: index terms at fixed word offsets, with an allowed slop
+ *                      - ENTITY: an organization or person filter (exact name or prefix)
+ *                      - RANGE: a metadata filter: a range of publication times, or a site or language
+ *                      - AND, OR: every child / any child. NOT children of an AND are subtracted from it
+ *                      - NOT: the single child is excluded; only meaningful inside an AND
+ */
+
+#ifndef INC_22S_FINAL_PROJ_QUERYNODE_H
+#define INC_22S_FINAL_PROJ_QUERYNODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "EntityDictionary.h"
+#include "FilterCache.h"
+#include "Metadata.h"
+
+struct QueryNode {
+    enum class Type : uint8_t {
+        TERM,
+        PHRASE,
+        ENTITY,
+        RANGE,
+        AND,
+        OR,
+        NOT,
+    };
+
+    Type type;
+
+    /// \description TERM: index term
+    std::string term;
+    /// \description TERM: fields searched, bit f set for Field f
+    uint8_t fields = 0;
+
+    /// \description PHRASE: (index term, word offset in the phrase). Words that are not indexed keep their offset
+    std::vector<std::pair<std::string, uint32_t>> phrase;
+    /// \description PHRASE: extra words allowed between the terms; 0 is an exact phrase
+    uint32_t slop = 0;
+
+    /// \description RANGE: column filtered on. PUBLISHED keeps times in [low, high] (seconds since the epoch);
+    ///              SITE and LANGUAGE compare to "name", every value starting with it when "prefix" is set
+    Column column = Column::PUBLISHED;
+    int64_t low = 0;
+    int64_t high = 0;
+
+    /// \description ENTITY: kind, normalized name, and whether every entity starting with it matches
+    Entity kind = Entity::ORGANIZATION;
+    std::string name;
+    bool prefix = false;
+    /// \description ENTITY: ids the name resolved to in the dictionary of the generation being searched
+    std::vector<EntityId> entities;
+    /// \description ENTITY: the filter's bitmap for every segment of that generation, when a FilterCache has it.
+    ///              RANGE: always set by the planner, from the segments' columns or a FilterCache
+    std::shared_ptr<const FilterBitmaps> bitmaps;
+
+    /// \description AND, OR, NOT: operands. The planner reorders the operands of an AND
+    std::vector<std::unique_ptr<QueryNode>> children;
+
+    /// \description Planner: estimated number of matching documents in the generation being searched
+    size_t estimate = 0;
+    /// \description Planner, operands of an AND: whether their postings gallop to the AND's candidates (they are
+    ///              much larger than the lead) or merge through them linearly
+    bool gallop = true;
+
+    /// \description EXPLAIN: documents the node's iterators produced and seconds spent in them, over all segments
+    size_t produced = 0;
+    double seconds = 0;
+
+    explicit QueryNode(Type type) : type(type) {}
+};
+
+#endif //INC_22S_FINAL_PROJ_QUERYNODE_H
@@ -0,0 +1,217 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Rcu.h
+ * @date:           10-19-2026
+ * @description:    Read-copy-update publication of immutable objects.
+ *                      - Readers pin the current version lock-free (one CAS on a per-reader slot and two
+ *                        stores) and never block writers or each other
+ *                      - Writers build a new version on the side and swap it in atomically
+ *                      - The old version is retired and destroyed once every reader that could still
+ *                        see it has unpinned (epoch-based reclamation)
+ *                  Versions are held through std::shared_ptr, so a reader that needs a version past the
+ *                  end of its pin (e.g. a result cursor) can retain() a counted reference to it.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_RCU_H
+#define INC_22S_FINAL_PROJ_RCU_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class RcuDomain {
+private:
+    static constexpr size_t MAX_READERS = 256;
+
+    struct alignas(64) ReaderSlot {
+        //0 when the slot holds no pin, otherwise the global epoch seen when pinning
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> in_use{false};
+    };
+
+    ReaderSlot slots[MAX_READERS];
+    std::atomic<uint64_t> global_epoch{1};
+
+    std::mutex retire_mutex;
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+    std::atomic<size_t> retired_count{0};
+
+    /// \return size_t      -> Index of a free reader slot, now owned by the caller
+    size_t acquire_slot() {
+        thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_READERS;
+        for (;;) {
+            for (size_t i = 0; i < MAX_READERS; ++i) {
+                size_t slot = (hint + i) % MAX_READERS;
+                bool expected = false;
+                if (!slots[slot].in_use.load(std::memory_order_relaxed) &&
+                    slots[slot].in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    hint = slot;
+                    return slot;
+                }
+            }
+            //More than MAX_READERS concurrent pins: wait for one to go away
+            std::this_thread::yield();
+        }
+    }
+
+public:
+    RcuDomain() = default;
+
+    RcuDomain(const RcuDomain &) = delete;
+
+    RcuDomain &operator=(const RcuDomain &) = delete;
+
+    ~RcuDomain() {
+        //No reader can be left once the owner is being destroyed
+        for (auto &entry: retired) entry.second();
+    }
+
+    /// \description Pins the current epoch for as long as it lives
+    class Pin {
+    private:
+        RcuDomain *domain = nullptr;
+        size_t slot = 0;
+
+    public:
+        Pin() = default;
+
+        explicit Pin(RcuDomain &rcu) : domain(&rcu), slot(rcu.acquire_slot()) {
+            uint64_t epoch = rcu.global_epoch.load(std::memory_order_seq_cst);
+            rcu.slots[slot].epoch.store(epoch, std::memory_order_seq_cst);
+        }
+
+        Pin(const Pin &) = delete;
+
+        Pin &operator=(const Pin &) = delete;
+
+        Pin(Pin &&pin) noexcept: domain(pin.domain), slot(pin.slot) { pin.domain = nullptr; }
+
+        Pin &operator=(Pin &&pin) noexcept {
+            if (this != &pin) {
+                release();
+                domain = pin.domain;
+                slot = pin.slot;
+                pin.domain = nullptr;
+            }
+            return *this;
+        }
+
+        ~Pin() { release(); }
+
+        void release() {
+            if (domain == nullptr) return;
+            domain->slots[slot].epoch.store(0, std::memory_order_release);
+            domain->slots[slot].in_use.store(false, std::memory_order_release);
+            domain = nullptr;
+        }
+    };
+
+    /// \param deleter      -> Frees an object that was just unpublished
+    /// \description        -> Defers "deleter" until every reader pinned before this call has unpinned
+    void retire(std::function<void()> deleter) {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+        uint64_t epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst);
+        retired.emplace_back(epoch, std::move(deleter));
+        retired_count.store(retired.size(), std::memory_order_relaxed);
+    }
+
+    /// \return bool        -> Whether retired objects are waiting to be reclaimed
+    bool has_retired() const { return retired_count.load(std::memory_order_relaxed) != 0; }
+
+    /// \description        -> Runs the deleters of objects no pinned reader can still see. Cheap when there
+    ///                     is nothing to do; meant for writer or background threads, never for readers
+    void reclaim() {
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(retire_mutex);
+            if (retired.empty()) return;
+            uint64_t oldest_pin = UINT64_MAX;
+            for (const ReaderSlot &slot: slots) {
+                uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+                if (epoch != 0 && epoch < oldest_pin) oldest_pin = epoch;
+            }
+            //An object retired at epoch e may be seen by pins taken at epochs <= e
+            auto keep = retired.begin();
+            for (auto &entry: retired) {
+                if (entry.first < oldest_pin) {
+                    ready.push_back(std::move(entry.second));
+                } else {
+                    *keep++ = std::move(entry);
+                }
+            }
+            retired.erase(keep, retired.end());
+            retired_count.store(retired.size(), std::memory_order_relaxed);
+        }
+        //Destroy outside the lock, it may be expensive
+        for (auto &deleter: ready) deleter();
+    }
+};
+
+template<typename T>
+class RcuCell {
+private:
+    mutable RcuDomain domain;
+    std::atomic<const std::shared_ptr<const T> *> holder;
+
+public:
+    explicit RcuCell(std::shared_ptr<const T> initial) : holder(new std::shared_ptr<const T>(std::move(initial))) {}
+
+    RcuCell(const RcuCell &) = delete;
+
+    RcuCell &operator=(const RcuCell &) = delete;
+
+    ~RcuCell() { delete holder.load(std::memory_order_relaxed); }
+
+    /// \description A pinned, read-only view of the version that was current when it was taken
+    class ReadGuard {
+    private:
+        RcuDomain::Pin pin;
+        const std::shared_ptr<const T> *version = nullptr;
+
+    public:
+        ReadGuard() = default;
+
+        ReadGuard(RcuDomain::Pin &&pin, const std::shared_ptr<const T> *version) : pin(std::move(pin)),
+                                                                                   version(version) {}
+
+        const T &operator*() const { return **version; }
+
+        const T *operator->() const { return version->get(); }
+
+        const T *get() const { return version->get(); }
+
+        /// \return shared_ptr  -> Counted reference that keeps this version alive after the guard is gone
+        std::shared_ptr<const T> retain() const { return *version; }
+    };
+
+    /// \return ReadGuard   -> The current version, pinned. Lock-free
+    ReadGuard read() const {
+        RcuDomain::Pin pin(domain);
+        return ReadGuard(std::move(pin), holder.load(std::memory_order_seq_cst));
+    }
+
+    /// \return shared_ptr  -> The current version. Only for the (externally serialized) writer
+    std::shared_ptr<const T> current() const { return *holder.load(std::memory_order_acquire); }
+
+    /// \param next         -> New version. Writers must be serialized by the caller
+    /// \description        -> Swaps "next" in and retires the previous version
+    void publish(std::shared_ptr<const T> next) {
+        auto *fresh = new std::shared_ptr<const T>(std::move(next));
+        const std::shared_ptr<const T> *old = holder.exchange(fresh, std::memory_order_seq_cst);
+        domain.retire([old] { delete old; });
+        domain.reclaim();
+    }
+
+    /// \description        -> Frees retired versions whose readers have all left
+    void reclaim() { domain.reclaim(); }
+
+    bool has_retired() const { return domain.has_retired(); }
+};
+
+#endif //INC_22S_FINAL_PROJ_RCU_H
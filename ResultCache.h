@@ -0,0 +1,139 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       ResultCache.h
+ * @date:           10-19-2026
+ * @description:    Sharded LRU cache of query results. Entries are keyed on the canonical form of a parsed
+ *                  query (Query::canonical) and tagged with the number of the index generation they were
+ *                  computed on: a lookup from another generation misses, and the first lookup or insert that
+ *                  brings a newer generation into a shard drops everything the shard held. Keys are spread
+ *                  over the shards by hash so concurrent searches rarely share a lock.
+ *                  A cache serves one Index: generation numbers of different indexes are not comparable.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_RESULTCACHE_H
+#define INC_22S_FINAL_PROJ_RESULTCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template<typename V>
+class ResultCache {
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const V> value;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        //Most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> positions;
+        //Generation every entry of the shard was computed on
+        uint64_t generation = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shard_capacity;
+    std::atomic<uint64_t> hit_count{0};
+    std::atomic<uint64_t> miss_count{0};
+
+    Shard &shard_of(const std::string &key) { return *shards[std::hash<std::string>()(key) % shards.size()]; }
+
+    /// \description        -> Empties "shard" if "generation" is newer than its entries. Caller holds its mutex
+    /// \return bool        -> Whether "generation" is the shard's generation (an older one cannot be cached)
+    static bool advance(Shard &shard, uint64_t generation) {
+        if (generation > shard.generation) {
+            shard.entries.clear();
+            shard.positions.clear();
+            shard.generation = generation;
+        }
+        return generation == shard.generation;
+    }
+
+public:
+    /// \param capacity     -> Maximum number of cached results, over all shards; 0 disables the cache
+    /// \param shard_count  -> Number of independently locked shards
+    explicit ResultCache(size_t capacity = 1024, size_t shard_count = 16)
+            : shard_capacity((capacity + shard_count - 1) / shard_count) {
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    ResultCache(const ResultCache &) = delete;
+
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    /// \param key          -> Canonical query
+    /// \param generation   -> Number of the generation being searched
+    /// \return V*          -> The result cached for "key" on that generation, or nullptr (a miss)
+    std::shared_ptr<const V> find(const std::string &key, uint64_t generation) {
+        Shard &shard = shard_of(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto position = advance(shard, generation) ? shard.positions.find(key) : shard.positions.end();
+            if (position != shard.positions.end()) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, position->second);
+                hit_count.fetch_add(1, std::memory_order_relaxed);
+                return position->second->value;
+            }
+        }
+        miss_count.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    /// \param key          -> Canonical query
+    /// \param generation   -> Number of the generation "value" was computed on
+    /// \param value        -> Result to cache, replacing any previous one; the least recently used entry of the
+    ///                     shard is evicted when it is full
+    /// \return V*          -> The cached result
+    std::shared_ptr<const V> insert(const std::string &key, uint64_t generation, V &&value) {
+        auto cached = std::make_shared<const V>(std::move(value));
+        if (shard_capacity == 0) {
+            return cached;
+        }
+        Shard &shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!advance(shard, generation)) {
+            return cached;
+        }
+        auto position = shard.positions.find(key);
+        if (position != shard.positions.end()) {
+            shard.entries.erase(position->second);
+            shard.positions.erase(position);
+        } else if (shard.entries.size() == shard_capacity) {
+            shard.positions.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+        shard.entries.push_front({key, cached});
+        shard.positions.emplace(key, shard.entries.begin());
+        return cached;
+    }
+
+    /// \return uint64_t    -> Lookups answered from the cache
+    uint64_t hits() const { return hit_count.load(std::memory_order_relaxed); }
+
+    /// \return uint64_t    -> Lookups that had to be computed
+    uint64_t misses() const { return miss_count.load(std::memory_order_relaxed); }
+
+    /// \return size_t      -> Number of cached results, stale ones included until their shard moves on
+    size_t size() {
+        size_t total = 0;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->entries.size();
+        }
+        return total;
+    }
+};
+
+#endif //INC_22S_FINAL_PROJ_RESULTCACHE_H
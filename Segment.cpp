@@ -0,0 +1,334 @@
+#include "Segment.h"
+
+#include <algorithm>
+#include <future>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+Segment::Segment(std::vector<DocId> &&docs, std::vector<std::string> &&sorted_terms, FieldPostings &&postings,
+                 std::vector<std::vector<uint8_t>> &&positions, bool positional, EntityIndex &&entities,
+                 Metadata &&metadata)
+        : docs(std::move(docs)), field_postings(std::move(postings)), term_positions(std::move(positions)),
+          positional(positional), entity_index(std::move(entities)), metadata_columns(std::move(metadata)) {
+    //Term ids follow term order, so the dictionary is bulk-built from an already sorted run
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> sorted_run;
+    sorted_run.reserve(sorted_terms.size());
+    for (size_t id = 0; id < sorted_terms.size(); ++id) {
+        sorted_run.emplace_back(std::move(sorted_terms[id]), std::vector<uint32_t>{static_cast<uint32_t>(id)});
+    }
+    terms = AvlTree<std::string, uint32_t>(std::move(sorted_run));
+    for (auto &field: field_postings) {
+        field.resize(terms.size());
+    }
+    if (this->positional) {
+        term_positions.resize(terms.size());
+    }
+}
+
+std::shared_ptr<const Segment> Segment::merge(const std::vector<std::shared_ptr<const Segment>> &sources,
+                                              const std::vector<std::shared_ptr<const Bitmap>> &deletions) {
+    //Positions cannot be made up for the documents of a segment indexed without them, and dropping the others'
+    //would silently turn phrase queries off: the Index never mixes the two, so a mix here is a bug
+    bool positional = std::all_of(sources.cbegin(), sources.cend(),
+                                  [](const auto &source) { return source->positional; });
+    if (!positional && std::any_of(sources.cbegin(), sources.cend(),
+                                   [](const auto &source) { return source->positional; })) {
+        throw std::logic_error("Segment::merge of segments with and without word positions");
+    }
+
+    //1- Merge the live document lists and remember where every source ordinal ends up
+    constexpr uint32_t DROPPED = UINT32_MAX;
+    auto is_deleted = [&deletions](size_t source, uint32_t local) {
+        return deletions[source] != nullptr && deletions[source]->test(local);
+    };
+    std::vector<DocId> merged_docs;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        for (uint32_t local = 0; local < sources[s]->docs.size(); ++local) {
+            if (!is_deleted(s, local)) merged_docs.push_back(sources[s]->docs[local]);
+        }
+    }
+    std::sort(merged_docs.begin(), merged_docs.end());
+    std::vector<std::vector<uint32_t>> remap(sources.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        remap[s].reserve(sources[s]->docs.size());
+        for (uint32_t local = 0; local < sources[s]->docs.size(); ++local) {
+            if (is_deleted(s, local)) {
+                remap[s].push_back(DROPPED);
+                continue;
+            }
+            auto position = std::lower_bound(merged_docs.cbegin(), merged_docs.cend(), sources[s]->docs[local]);
+            remap[s].push_back(static_cast<uint32_t>(position - merged_docs.cbegin()));
+        }
+    }
+
+    //Entity postings only need the remapping, so they are merged alongside the terms
+    std::future<EntityIndex> entities = std::async(std::launch::async, [&sources, &remap] {
+        EntityPostings merged;
+        for (size_t kind = 0; kind < ENTITY_KIND_COUNT; ++kind) {
+            for (size_t s = 0; s < sources.size(); ++s) {
+                sources[s]->entity_index.for_each(static_cast<Entity>(kind), [&merged, &remap, kind, s](
+                        EntityId entity, const std::vector<uint32_t> &ordinals) {
+                    std::vector<uint32_t> &list = merged[kind][entity];
+                    for (uint32_t local: ordinals) {
+                        if (remap[s][local] != DROPPED) list.push_back(remap[s][local]);
+                    }
+                });
+            }
+            for (auto entry = merged[kind].begin(); entry != merged[kind].end();) {
+                if (entry->second.empty()) {
+                    entry = merged[kind].erase(entry);
+                    continue;
+                }
+                if (!std::is_sorted(entry->second.cbegin(), entry->second.cend())) {
+                    std::sort(entry->second.begin(), entry->second.end());
+                }
+                ++entry;
+            }
+        }
+        return EntityIndex(std::move(merged));
+    });
+    //Metadata is rebuilt in merged order; the dictionaries are sorted again by the builder
+    std::future<Metadata> metadata = std::async(std::launch::async, [&sources, &remap, &merged_docs] {
+        std::vector<std::pair<size_t, uint32_t>> origins(merged_docs.size());
+        for (size_t s = 0; s < sources.size(); ++s) {
+            for (uint32_t local = 0; local < remap[s].size(); ++local) {
+                if (remap[s][local] != DROPPED) origins[remap[s][local]] = {s, local};
+            }
+        }
+        MetadataBuilder builder;
+        for (const auto &[s, local]: origins) {
+            const Metadata &columns = sources[s]->metadata_columns;
+            builder.add(columns.published_at(local), columns.value(Column::SITE, local),
+                        columns.value(Column::LANGUAGE, local));
+        }
+        return builder.finish();
+    });
+
+    //2- Flatten each dictionary into a sorted list of (term, term id)
+    using Entry = std::pair<const std::string *, uint32_t>;
+    std::vector<std::vector<Entry>> runs(sources.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        runs[s].reserve(sources[s]->term_count());
+        sources[s]->for_each_term([&runs, s](const std::string &term, uint32_t id) {
+            runs[s].emplace_back(&term, id);
+        });
+    }
+
+    //3- K-way merge of the runs. Equal terms from several sources become one postings list per field
+    using Cursor = std::pair<size_t, size_t>; //(source, position in run)
+    auto greater = [&runs](const Cursor &a, const Cursor &b) {
+        const std::string &term_a = *runs[a.first][a.second].first;
+        const std::string &term_b = *runs[b.first][b.second].first;
+        return term_b < term_a || (!(term_a < term_b) && b.first < a.first);
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+    for (size_t s = 0; s < runs.size(); ++s) {
+        if (!runs[s].empty()) heap.emplace(s, 0);
+    }
+
+    //A posting of the merged term, with its positions entry (a self-contained slice of the source blob)
+    struct Posting {
+        uint32_t ordinal;
+        const uint8_t *entry;
+        size_t length;
+
+        bool operator<(const Posting &posting) const { return ordinal < posting.ordinal; }
+    };
+    std::array<std::vector<Posting>, FIELD_COUNT> merged_postings;
+    std::vector<std::string> sorted_terms;
+    FieldPostings postings;
+    std::vector<std::vector<uint8_t>> positions;
+    while (!heap.empty()) {
+        const std::string &term = *runs[heap.top().first][heap.top().second].first;
+        for (auto &field: merged_postings) field.clear();
+        while (!heap.empty() && *runs[heap.top().first][heap.top().second].first == term) {
+            Cursor cursor = heap.top();
+            heap.pop();
+            const Segment &source = *sources[cursor.first];
+            uint32_t id = runs[cursor.first][cursor.second].second;
+            for (size_t f = 0; f < FIELD_COUNT; ++f) {
+                bool with_positions = positional && f == static_cast<size_t>(Field::TEXT);
+                Positions::Reader reader;
+                if (with_positions) reader = Positions::Reader(source.term_positions[id]);
+                for (uint32_t local: source.field_postings[f][id]) {
+                    std::pair<const uint8_t *, size_t> slice{nullptr, 0};
+                    if (with_positions) slice = reader.next_entry();
+                    uint32_t merged = remap[cursor.first][local];
+                    if (merged != DROPPED) merged_postings[f].push_back({merged, slice.first, slice.second});
+                }
+            }
+            if (cursor.second + 1 < runs[cursor.first].size()) {
+                heap.emplace(cursor.first, cursor.second + 1);
+            }
+        }
+        //Every document of the term was deleted
+        if (std::all_of(merged_postings.cbegin(), merged_postings.cend(),
+                        [](const auto &field) { return field.empty(); })) {
+            continue;
+        }
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            //Sources covering interleaved document ranges need their contributions merged
+            if (!std::is_sorted(merged_postings[f].cbegin(), merged_postings[f].cend())) {
+                std::sort(merged_postings[f].begin(), merged_postings[f].end());
+            }
+            std::vector<uint32_t> list;
+            list.reserve(merged_postings[f].size());
+            for (const Posting &posting: merged_postings[f]) {
+                list.push_back(posting.ordinal);
+            }
+            postings[f].push_back(std::move(list));
+        }
+        if (positional) {
+            std::vector<uint8_t> blob;
+            for (const Posting &posting: merged_postings[static_cast<size_t>(Field::TEXT)]) {
+                blob.insert(blob.end(), posting.entry, posting.entry + posting.length);
+            }
+            positions.push_back(std::move(blob));
+        }
+        //"term" points into a source, so it is copied before the next group is read
+        sorted_terms.push_back(term);
+    }
+
+    //4- Bulk-build the merged dictionary
+    return std::make_shared<const Segment>(std::move(merged_docs), std::move(sorted_terms), std::move(postings),
+                                           std::move(positions), positional, entities.get(), metadata.get());
+}
+
+std::vector<std::shared_ptr<const Segment>> Segment::split(const Segment &source, const std::vector<uint32_t> &parts,
+                                                           size_t count) {
+    //1- Each part keeps its documents in order, renumbered from 0
+    std::vector<std::vector<DocId>> docs(count);
+    std::vector<uint32_t> local_of(source.docs.size());
+    for (uint32_t local = 0; local < source.docs.size(); ++local) {
+        local_of[local] = static_cast<uint32_t>(docs[parts[local]].size());
+        docs[parts[local]].push_back(source.docs[local]);
+    }
+
+    //2- Entities and metadata, ordinal by ordinal
+    std::vector<EntityPostings> entities(count);
+    for (size_t kind = 0; kind < ENTITY_KIND_COUNT; ++kind) {
+        source.entity_index.for_each(static_cast<Entity>(kind), [&](EntityId entity,
+                                                                    const std::vector<uint32_t> &ordinals) {
+            for (uint32_t local: ordinals) {
+                entities[parts[local]][kind][entity].push_back(local_of[local]);
+            }
+        });
+    }
+    std::vector<MetadataBuilder> metadata(count);
+    for (uint32_t local = 0; local < source.docs.size(); ++local) {
+        metadata[parts[local]].add(source.metadata_columns.published_at(local),
+                                   source.metadata_columns.value(Column::SITE, local),
+                                   source.metadata_columns.value(Column::LANGUAGE, local));
+    }
+
+    //3- Terms in order: a part gets the term (and a new term id) at the first of its documents that has it
+    std::vector<std::vector<std::string>> sorted_terms(count);
+    std::vector<FieldPostings> postings(count);
+    std::vector<std::vector<std::vector<uint8_t>>> positions(count);
+    std::vector<uint8_t> has_term(count, 0);
+    std::vector<uint32_t> touched;
+    source.for_each_term([&](const std::string &term, uint32_t id) {
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            bool with_positions = source.positional && f == static_cast<size_t>(Field::TEXT);
+            Positions::Reader reader;
+            if (with_positions) reader = Positions::Reader(source.term_positions[id]);
+            for (uint32_t local: source.field_postings[f][id]) {
+                uint32_t part = parts[local];
+                if (!has_term[part]) {
+                    has_term[part] = 1;
+                    touched.push_back(part);
+                    sorted_terms[part].push_back(term);
+                    for (auto &field: postings[part]) field.emplace_back();
+                    if (source.positional) positions[part].emplace_back();
+                }
+                postings[part][f].back().push_back(local_of[local]);
+                if (with_positions) {
+                    std::pair<const uint8_t *, size_t> slice = reader.next_entry();
+                    positions[part].back().insert(positions[part].back().end(), slice.first,
+                                                  slice.first + slice.second);
+                }
+            }
+        }
+        for (uint32_t part: touched) {
+            has_term[part] = 0;
+        }
+        touched.clear();
+    });
+
+    //4- Bulk-build every part's dictionary
+    std::vector<std::shared_ptr<const Segment>> segments(count);
+    for (size_t part = 0; part < count; ++part) {
+        if (docs[part].empty()) {
+            continue;
+        }
+        segments[part] = std::make_shared<const Segment>(std::move(docs[part]), std::move(sorted_terms[part]),
+                                                         std::move(postings[part]), std::move(positions[part]),
+                                                         source.positional, EntityIndex(std::move(entities[part])),
+                                                         metadata[part].finish());
+    }
+    return segments;
+}
+
+uint32_t SegmentBuilder::intern(const std::string &term) {
+    auto [entry, inserted] = term_ids.try_emplace(term, static_cast<uint32_t>(term_ids.size()));
+    if (inserted) {
+        for (auto &field: postings) field.emplace_back();
+        if (positional) positions.emplace_back();
+    }
+    return entry->second;
+}
+
+void SegmentBuilder::add(DocId id, const Article &article, const EntityIds &entities) {
+    auto local = static_cast<uint32_t>(docs.size());
+    docs.push_back(id);
+    for (size_t i = 0; i < article.tokens.size(); ++i) {
+        uint32_t term = intern(article.tokens[i]);
+        postings[static_cast<size_t>(Field::TEXT)][term].push_back(local);
+        if (positional) {
+            //Articles that were not tokenized with positions still get an (empty) entry per posting
+            static const std::vector<uint32_t> none;
+            Positions::append(positions[term], i < article.positions.size() ? article.positions[i] : none);
+        }
+    }
+    for (const std::string &token: article.title_tokens) {
+        postings[static_cast<size_t>(Field::TITLE)][intern(token)].push_back(local);
+    }
+    EntityIndex::add(entity_postings, entities, local);
+    metadata.add(article);
+}
+
+std::shared_ptr<const Segment> SegmentBuilder::finish() {
+    std::future<EntityIndex> entities = std::async(std::launch::async,
+                                                   [postings = std::move(entity_postings)]() mutable {
+                                                       return EntityIndex(std::move(postings));
+                                                   });
+    entity_postings = {};
+
+    //Renumber the term ids into term order
+    std::vector<std::pair<const std::string, uint32_t> *> order;
+    order.reserve(term_ids.size());
+    for (auto &entry: term_ids) {
+        order.push_back(&entry);
+    }
+    std::sort(order.begin(), order.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+    std::vector<std::string> sorted_terms;
+    FieldPostings sorted_postings;
+    std::vector<std::vector<uint8_t>> sorted_positions;
+    sorted_terms.reserve(order.size());
+    for (const auto *entry: order) {
+        sorted_terms.push_back(entry->first);
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            sorted_postings[f].push_back(std::move(postings[f][entry->second]));
+        }
+        if (positional) sorted_positions.push_back(std::move(positions[entry->second]));
+    }
+    auto segment = std::make_shared<const Segment>(std::move(docs), std::move(sorted_terms),
+                                                   std::move(sorted_postings), std::move(sorted_positions),
+                                                   positional, entities.get(), metadata.finish());
+    docs = {};
+    term_ids = {};
+    postings = {};
+    positions = {};
+    return segment;
+}
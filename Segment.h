@@ -0,0 +1,177 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Segment.h
+ * @date:           10-19-2026
+ * @description:    An immutable slice of the inverted index. A segment knows which documents it
+ *                  holds (global DocIds, ascending) and has one term dictionary shared by every field:
+ *                  it maps a term to a term id, and each field keeps its own postings per term id (the
+ *                  ascending local ordinals, i.e. positions in "docs", of the documents whose field
+ *                  contains the term). Term ids follow term order.
+ *                  Positional segments also keep a Positions blob per term id for the text field, with
+ *                  one entry per text posting. Entity tags (organizations, persons) have their own
+ *                  EntityIndex, and publication times, sites and languages are kept in Metadata columns.
+ *                  SegmentBuilder is the mutable in-memory buffer new documents are indexed into.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_SEGMENT_H
+#define INC_22S_FINAL_PROJ_SEGMENT_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Article.h"
+#include "AvlTree.h"
+#include "Bitmap.h"
+#include "EntityIndex.h"
+#include "Metadata.h"
+#include "Positions.h"
+
+/// \description Global document identifier, assigned by the Index in arrival order and never reused
+using DocId = uint32_t;
+
+/// \description postings[field][term id] -> ascending local ordinals
+using FieldPostings = std::array<std::vector<std::vector<uint32_t>>, FIELD_COUNT>;
+
+class Segment {
+private:
+    std::vector<DocId> docs;
+    //term -> {term id}
+    AvlTree<std::string, uint32_t> terms;
+    FieldPostings field_postings;
+    std::vector<std::vector<uint8_t>> term_positions;
+    bool positional;
+    EntityIndex entity_index;
+    Metadata metadata_columns;
+
+public:
+    /// \param docs         -> Global ids of the segment's documents, ascending
+    /// \param sorted_terms -> Distinct terms, ascending; term id i is sorted_terms[i]
+    /// \param postings     -> Per field, postings of every term id (empty when the field lacks the term)
+    /// \param positions    -> Text positions blob of every term id, aligned with the text postings
+    /// \param positional   -> Whether "positions" was recorded at all
+    /// \param entities     -> Entity postings of the documents
+    /// \param metadata     -> Metadata columns of the documents
+    Segment(std::vector<DocId> &&docs, std::vector<std::string> &&sorted_terms, FieldPostings &&postings,
+            std::vector<std::vector<uint8_t>> &&positions, bool positional, EntityIndex &&entities,
+            Metadata &&metadata);
+
+    Segment(const Segment &) = delete;
+
+    Segment &operator=(const Segment &) = delete;
+
+    /// \return size_t      -> Number of documents in the segment
+    size_t doc_count() const { return docs.size(); }
+
+    /// \return size_t      -> Number of distinct terms, over all fields
+    size_t term_count() const { return field_postings[0].size(); }
+
+    /// \return DocId       -> Global id of the document at local ordinal "local"
+    DocId global_id(uint32_t local) const { return docs[local]; }
+
+    const std::vector<DocId> &doc_ids() const { return docs; }
+
+    /// \param term         -> Stemmed term
+    /// \return uint32_t*   -> Id of "term", or nullptr if no field of the segment has it
+    const uint32_t *term_id(const std::string &term) const {
+        const std::vector<uint32_t> *id = terms.search(term);
+        return id == nullptr ? nullptr : &id->front();
+    }
+
+    /// \param term         -> Stemmed term
+    /// \param field        -> Field to look in
+    /// \return vector*     -> Ascending local ordinals of the documents whose "field" contains "term", or nullptr
+    const std::vector<uint32_t> *postings(const std::string &term, Field field = Field::TEXT) const {
+        const uint32_t *id = term_id(term);
+        if (id == nullptr) return nullptr;
+        const std::vector<uint32_t> &list = field_postings[static_cast<size_t>(field)][*id];
+        return list.empty() ? nullptr : &list;
+    }
+
+    /// \return vector      -> Postings of a term id in "field" (possibly empty)
+    const std::vector<uint32_t> &postings(uint32_t id, Field field) const {
+        return field_postings[static_cast<size_t>(field)][id];
+    }
+
+    /// \return bool        -> Whether word positions are indexed (phrase queries can be answered)
+    bool has_positions() const { return positional; }
+
+    /// \param term         -> Stemmed term
+    /// \return vector*     -> Positions blob of "term", aligned with postings(term, Field::TEXT), or nullptr
+    const std::vector<uint8_t> *positions(const std::string &term) const {
+        const uint32_t *id = term_id(term);
+        return id == nullptr || !positional ? nullptr : &term_positions[*id];
+    }
+
+    /// \return vector      -> Positions blob of a term id (empty when the segment is not positional)
+    const std::vector<uint8_t> &positions(uint32_t id) const {
+        static const std::vector<uint8_t> none;
+        return positional ? term_positions[id] : none;
+    }
+
+    /// \return EntityIndex -> Organizations and persons the documents are tagged with
+    const EntityIndex &entities() const { return entity_index; }
+
+    /// \return Metadata    -> Publication time, site and language of the documents, by local ordinal
+    const Metadata &metadata() const { return metadata_columns; }
+
+    /// \param f            -> Called with (term, term id) for every term, in term order
+    template<typename F>
+    void for_each_term(F &&f) const {
+        terms.in_order([&f](const std::string &term, const std::vector<uint32_t> &id) { f(term, id.front()); });
+    }
+
+    /// \param sources      -> Segments to combine
+    /// \param deletions    -> Tombstones of each source (nullptr entries when nothing is deleted)
+    /// \return Segment     -> One segment holding every live document of "sources". Terms are k-way merged
+    ///                     into a sorted run and the dictionary is bulk-built from it; deleted documents and
+    ///                     terms left without postings are dropped. Merging a single source compacts it.
+    ///                     Entity postings and metadata are remapped on other threads while the terms are merged.
+    ///                     Sources with and without word positions cannot be merged (std::logic_error)
+    static std::shared_ptr<const Segment> merge(const std::vector<std::shared_ptr<const Segment>> &sources,
+                                                const std::vector<std::shared_ptr<const Bitmap>> &deletions);
+
+    /// \param source       -> Segment to divide
+    /// \param parts        -> Part of every local ordinal of "source", below "count"
+    /// \param count        -> Number of parts
+    /// \return vector      -> One segment per part holding its documents, in the same order, with their postings,
+    ///                     positions, entities and metadata; nullptr for a part without documents. The source
+    ///                     dictionary is walked once, handing each term to the parts that have it
+    static std::vector<std::shared_ptr<const Segment>> split(const Segment &source, const std::vector<uint32_t> &parts,
+                                                             size_t count);
+};
+
+class SegmentBuilder {
+private:
+    std::vector<DocId> docs;
+    bool positional;
+    //Term ids in first-seen order; finish() renumbers them into term order
+    std::unordered_map<std::string, uint32_t> term_ids;
+    FieldPostings postings;
+    std::vector<std::vector<uint8_t>> positions;
+    EntityPostings entity_postings;
+    MetadataBuilder metadata;
+
+    /// \return uint32_t    -> Id of "term", added if new
+    uint32_t intern(const std::string &term);
+
+public:
+    /// \param positional   -> Also index word positions
+    explicit SegmentBuilder(bool positional = true) : positional(positional) {}
+
+    /// \param id           -> Global id of the document, greater than every id added before
+    /// \param article      -> Parsed article whose tokens are indexed, field by field, and whose metadata is kept
+    /// \param entities     -> Interned entities the article is tagged with
+    void add(DocId id, const Article &article, const EntityIds &entities);
+
+    /// \return size_t      -> Number of buffered documents
+    size_t doc_count() const { return docs.size(); }
+
+    /// \return Segment     -> Immutable segment holding every buffered document. The entity index is compressed
+    ///                     on another thread while the terms are sorted. The builder is left empty
+    std::shared_ptr<const Segment> finish();
+};
+
+#endif //INC_22S_FINAL_PROJ_SEGMENT_H
@@ -0,0 +1,106 @@
+#include "Snippet.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+std::string Snippet::build(const std::string &text, const std::vector<std::string> &terms, size_t words,
+                           const std::string &open, const std::string &close) {
+    if (words == 0) {
+        return "";
+    }
+    std::unordered_map<std::string, size_t> term_numbers;
+    //Stemming keeps a word's first letter, so only words starting like a term are worth stemming
+    bool initials[256] = {};
+    for (const std::string &term: terms) {
+        term_numbers.try_emplace(term, term_numbers.size());
+        if (!term.empty()) {
+            initials[static_cast<unsigned char>(term.front())] = true;
+        }
+    }
+
+    //1- Split into words like the Parser does, keeping where each one is and which query term it is, if any
+    struct Word {
+        size_t offset;
+        size_t length;
+        size_t term;
+    };
+    constexpr size_t NO_TERM = SIZE_MAX;
+    std::vector<Word> split;
+    std::vector<size_t> matches;
+    HashMap<std::string, std::string> stem_cache(50);
+    std::string token;
+    for (size_t begin = 0; begin < text.size();) {
+        size_t end = std::min(text.find(' ', begin), text.size());
+        if (end > begin) {
+            size_t term = NO_TERM;
+            size_t letter = begin;
+            while (letter < end && !std::isalpha(static_cast<unsigned char>(text[letter]))) {
+                ++letter;
+            }
+            if (letter < end && initials[std::tolower(static_cast<unsigned char>(text[letter]))]) {
+                token.assign(text, begin, end - begin);
+                auto number = Parser::normalize_token(token, stem_cache) ? term_numbers.find(token)
+                                                                         : term_numbers.end();
+                if (number != term_numbers.end()) {
+                    term = number->second;
+                    matches.push_back(split.size());
+                }
+            }
+            split.push_back({begin, end - begin, term});
+        }
+        begin = end + 1;
+    }
+
+    //2- Densest window: slide over the matches, keeping those within "words" of the newest one
+    size_t first = 0;
+    if (!matches.empty()) {
+        std::vector<size_t> in_window(term_numbers.size(), 0);
+        size_t distinct = 0;
+        size_t best_distinct = 0, best_count = 0, best_first = 0, best_last = 0;
+        for (size_t newest = 0, oldest = 0; newest < matches.size(); ++newest) {
+            distinct += in_window[split[matches[newest]].term]++ == 0;
+            while (matches[newest] - matches[oldest] >= words) {
+                distinct -= --in_window[split[matches[oldest]].term] == 0;
+                ++oldest;
+            }
+            size_t count = newest - oldest + 1;
+            if (distinct > best_distinct || (distinct == best_distinct && count > best_count)) {
+                best_distinct = distinct;
+                best_count = count;
+                best_first = matches[oldest];
+                best_last = matches[newest];
+            }
+        }
+        //Center the matches in the window, without running past either end of the text
+        size_t context = words - (best_last - best_first + 1);
+        first = best_first - std::min(best_first, context / 2);
+        first = std::min(first, split.size() > words ? split.size() - words : 0);
+    }
+    size_t last = std::min(first + words, split.size());
+
+    //3- Join the window's words on single spaces, highlighting the matches
+    std::string snippet = first > 0 ? "..." : "";
+    for (size_t i = first; i < last; ++i) {
+        if (i > first) {
+            snippet += ' ';
+        }
+        if (split[i].term != NO_TERM) {
+            snippet += open;
+        }
+        snippet.append(text, split[i].offset, split[i].length);
+        if (split[i].term != NO_TERM) {
+            snippet += close;
+        }
+    }
+    if (last < split.size()) {
+        snippet += "...";
+    }
+    for (char &c: snippet) {
+        if (c == '\n' || c == '\r' || c == '\t') {
+            c = ' ';
+        }
+    }
+    return snippet;
+}
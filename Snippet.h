@@ -0,0 +1,37 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       Snippet.h
+ * @date:           10-19-2026
+ * @description:    Query-biased snippets of a result's text. Only the fetched document is tokenized again,
+ *                  the way the Parser indexes it (space-separated words, Parser::normalize_token), so nothing
+ *                  is added to the index and the cost is paid for the results on screen only.
+ *                      - Every word whose index term is a query term is a match
+ *                      - The window of "words" consecutive words with the most distinct query terms (then the
+ *                        most matches) is kept, centered on its matches
+ *                      - Matches are wrapped in highlight markers; "..." marks text cut on either side
+ *                  A text without any match gives its first words.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_SNIPPET_H
+#define INC_22S_FINAL_PROJ_SNIPPET_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Snippet {
+public:
+    static constexpr size_t DEFAULT_WORDS = 30;
+
+    /// \param text         -> Article text
+    /// \param terms        -> Index terms (stemmed) to highlight, e.g. Query::highlighted_terms
+    /// \param words        -> Maximum number of words in the snippet
+    /// \param open         -> Inserted before every match
+    /// \param close        -> Inserted after every match
+    /// \return string      -> The snippet, on a single line
+    static std::string build(const std::string &text, const std::vector<std::string> &terms,
+                             size_t words = DEFAULT_WORDS, const std::string &open = "**",
+                             const std::string &close = "**");
+};
+
+#endif //INC_22S_FINAL_PROJ_SNIPPET_H
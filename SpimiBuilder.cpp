@@ -0,0 +1,201 @@
+#include "SpimiBuilder.h"
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <utility>
+
+/// \param output       -> Index directory
+/// \return path        -> Its documents file, after creating the directory and removing the uuid table of an
+///                     index saved there before (Index::load rehashes the uuids when it is missing)
+static std::filesystem::path documents_path(const std::filesystem::path &output) {
+    std::filesystem::create_directories(output);
+    std::filesystem::remove(output / IndexFile::UUIDS);
+    return output / IndexFile::DOCUMENTS;
+}
+
+SpimiBuilder::SpimiBuilder(const std::filesystem::path &output, SpimiConfig config)
+        : output(output), temp_dir(config.temp_dir.empty() ? output / "runs" : config.temp_dir),
+          config(std::move(config)), documents(documents_path(output), IndexFile::DOCUMENTS_MAGIC) {
+    std::filesystem::create_directories(temp_dir);
+}
+
+SpimiBuilder::~SpimiBuilder() {
+    std::error_code error;
+    for (const auto &run: runs) {
+        std::filesystem::remove(run, error);
+    }
+    if (config.temp_dir.empty()) {
+        std::filesystem::remove(temp_dir, error);
+    }
+}
+
+SpimiBuilder::Postings &SpimiBuilder::entry(const std::string &term) {
+    //Rough heap cost of a hash node holding a string and the vectors, plus its bucket and malloc headers
+    constexpr size_t ENTRY_BYTES = 136;
+    constexpr size_t SSO_CAPACITY = 15;
+
+    auto [entry, inserted] = dictionary.try_emplace(term);
+    if (inserted) {
+        used_bytes += ENTRY_BYTES + (term.size() > SSO_CAPACITY ? term.size() + 1 : 0);
+    }
+    return entry->second;
+}
+
+uint32_t SpimiBuilder::add(const Article &article) {
+    constexpr size_t TEXT = static_cast<size_t>(Field::TEXT);
+    constexpr size_t TITLE = static_cast<size_t>(Field::TITLE);
+
+    uint32_t ordinal = next_ordinal++;
+    documents.put_article(article);
+    for (size_t i = 0; i < article.tokens.size(); ++i) {
+        Postings &postings = entry(article.tokens[i]);
+        size_t old_bytes = postings.ordinals[TEXT].capacity() * sizeof(uint32_t) + postings.positions.capacity();
+        postings.ordinals[TEXT].push_back(ordinal);
+        if (config.positions) {
+            static const std::vector<uint32_t> none;
+            Positions::append(postings.positions, i < article.positions.size() ? article.positions[i] : none);
+        }
+        used_bytes += postings.ordinals[TEXT].capacity() * sizeof(uint32_t) + postings.positions.capacity() -
+                      old_bytes;
+    }
+    for (const std::string &token: article.title_tokens) {
+        std::vector<uint32_t> &ordinals = entry(token).ordinals[TITLE];
+        size_t old_bytes = ordinals.capacity() * sizeof(uint32_t);
+        ordinals.push_back(ordinal);
+        used_bytes += ordinals.capacity() * sizeof(uint32_t) - old_bytes;
+    }
+    if (used_bytes >= config.memory_budget) {
+        spill();
+    }
+    return ordinal;
+}
+
+void SpimiBuilder::spill() {
+    if (dictionary.empty()) {
+        return;
+    }
+    //1- Sort the terms; the postings are already ascending because ordinals only grow
+    std::vector<std::pair<const std::string, Postings> *> sorted;
+    sorted.reserve(dictionary.size());
+    for (auto &entry: dictionary) {
+        sorted.push_back(&entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+
+    //2- Write them out as a run
+    std::filesystem::path run = temp_dir / ("run-" + std::to_string(runs_created++) + ".dat");
+    RecordWriter writer(run, IndexFile::RUN_MAGIC, config.positions);
+    for (const auto *entry: sorted) {
+        const auto &ordinals = entry->second.ordinals;
+        writer.put_term(entry->first, {&ordinals[0], &ordinals[1]}, &entry->second.positions);
+    }
+    writer.finish();
+    runs.push_back(run);
+
+    //3- Give the memory back (clear() would keep the bucket array)
+    sorted = {};
+    dictionary = {};
+    used_bytes = 0;
+}
+
+void SpimiBuilder::merge_runs(const std::vector<std::filesystem::path> &inputs,
+                              const std::filesystem::path &output_path, uint32_t magic, bool positional) {
+    struct Cursor {
+        RecordReader reader;
+        std::string term;
+        std::array<std::vector<uint32_t>, FIELD_COUNT> postings;
+        std::vector<uint8_t> positions;
+
+        void next() { reader.get_term(term, postings, &positions); }
+    };
+    std::vector<Cursor> cursors;
+    cursors.reserve(inputs.size());
+    for (const auto &input: inputs) {
+        cursors.push_back({RecordReader(input, IndexFile::RUN_MAGIC), {}, {}, {}});
+    }
+
+    //Smallest term first; on ties the earlier run first, so concatenated postings stay ascending
+    auto greater = [&cursors](size_t a, size_t b) {
+        int order = cursors[a].term.compare(cursors[b].term);
+        return order > 0 || (order == 0 && a > b);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (!cursors[i].reader.done()) {
+            cursors[i].next();
+            heap.push(i);
+        }
+    }
+
+    RecordWriter writer(output_path, magic, positional);
+    std::string term;
+    bool pending = false;
+    std::array<std::vector<uint32_t>, FIELD_COUNT> postings;
+    std::vector<uint8_t> positions;
+    auto put = [&writer, &term, &postings, &positions]() {
+        writer.put_term(term, {&postings[0], &postings[1]}, &positions);
+        for (auto &field: postings) {
+            field.clear();
+        }
+        positions.clear();
+    };
+    while (!heap.empty()) {
+        size_t top = heap.top();
+        heap.pop();
+        if (pending && cursors[top].term != term) {
+            put();
+            pending = false;
+        }
+        if (!pending) {
+            term = cursors[top].term;
+            pending = true;
+        }
+        //Position entries follow text postings order, so they are concatenated the same way
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            postings[f].insert(postings[f].end(), cursors[top].postings[f].cbegin(), cursors[top].postings[f].cend());
+        }
+        positions.insert(positions.end(), cursors[top].positions.cbegin(), cursors[top].positions.cend());
+        if (!cursors[top].reader.done()) {
+            cursors[top].next();
+            heap.push(top);
+        }
+    }
+    if (pending) {
+        put();
+    }
+    writer.finish();
+}
+
+void SpimiBuilder::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    spill();
+    documents.finish();
+
+    //1- Too many runs to open at once: merge them in groups (ordinal order is kept) until few are left
+    while (runs.size() > MAX_MERGE_WAY) {
+        std::vector<std::filesystem::path> next;
+        for (size_t first = 0; first < runs.size(); first += MAX_MERGE_WAY) {
+            std::vector<std::filesystem::path> group(runs.begin() + static_cast<long>(first),
+                                                     runs.begin() + static_cast<long>(
+                                                             std::min(first + MAX_MERGE_WAY, runs.size())));
+            std::filesystem::path merged = temp_dir / ("run-" + std::to_string(runs_created++) + ".dat");
+            merge_runs(group, merged, IndexFile::RUN_MAGIC, config.positions);
+            for (const auto &run: group) {
+                std::filesystem::remove(run);
+            }
+            next.push_back(merged);
+        }
+        runs.swap(next);
+    }
+
+    //2- Final merge straight into the index
+    merge_runs(runs, output / IndexFile::TERMS, IndexFile::TERMS_MAGIC, config.positions);
+    for (const auto &run: runs) {
+        std::filesystem::remove(run);
+    }
+    runs.clear();
+}
@@ -0,0 +1,97 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       SpimiBuilder.h
+ * @date:           10-19-2026
+ * @description:    Single-pass in-memory indexing (SPIMI) for corpora larger than RAM.
+ *                      - Each added document is written to documents.dat right away, only its tokens are kept
+ *                      - Tokens go into a hash dictionary (term -> ordinals per field) until it outgrows the memory
+ *                        budget; the dictionary is then sorted and spilled to a run file and emptied
+ *                      - finish() k-way merges the runs into terms.dat (several passes if there are more
+ *                        runs than MAX_MERGE_WAY), giving a directory Index::load can open
+ *                  The budget bounds the dictionary; documents in flight are bounded by the caller's batch.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_SPIMIBUILDER_H
+#define INC_22S_FINAL_PROJ_SPIMIBUILDER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Article.h"
+#include "IndexFile.h"
+#include "Positions.h"
+
+struct SpimiConfig {
+    /// \description Bytes the in-memory dictionary may use before it is spilled to a run
+    size_t memory_budget = size_t(256) << 20;
+    /// \description Where runs are spilled. Empty means a "runs" directory inside the output directory
+    std::filesystem::path temp_dir;
+    /// \description Index word positions, needed by phrase and proximity queries
+    bool positions = true;
+};
+
+class SpimiBuilder {
+private:
+    static constexpr size_t MAX_MERGE_WAY = 64;
+
+    std::filesystem::path output;
+    std::filesystem::path temp_dir;
+    SpimiConfig config;
+
+    RecordWriter documents;
+    uint32_t next_ordinal = 0;
+
+    struct Postings {
+        std::array<std::vector<uint32_t>, FIELD_COUNT> ordinals;
+        std::vector<uint8_t> positions;
+    };
+    std::unordered_map<std::string, Postings> dictionary;
+    size_t used_bytes = 0;
+    std::vector<std::filesystem::path> runs;
+    size_t runs_created = 0;
+    bool finished = false;
+
+    /// \description        -> Writes the dictionary, sorted by term, to a new run and empties it
+    void spill();
+
+    /// \param term         -> Token of "field"
+    /// \return Postings    -> Dictionary entry of "term", added (and accounted for) if new
+    Postings &entry(const std::string &term);
+
+    /// \param inputs       -> Runs to merge, in ordinal order
+    /// \param output_path  -> File receiving the merged terms
+    /// \param magic        -> Format of "output_path" (another run, or the final terms file)
+    /// \param positional   -> Whether the runs carry positions
+    static void merge_runs(const std::vector<std::filesystem::path> &inputs,
+                           const std::filesystem::path &output_path, uint32_t magic, bool positional);
+
+public:
+    /// \param output       -> Index directory to create
+    /// \param config       -> Memory budget and spill location
+    SpimiBuilder(const std::filesystem::path &output, SpimiConfig config = {});
+
+    SpimiBuilder(const SpimiBuilder &) = delete;
+
+    SpimiBuilder &operator=(const SpimiBuilder &) = delete;
+
+    /// \description        -> Removes leftover runs (of an unfinished build too)
+    ~SpimiBuilder();
+
+    /// \param article      -> Parsed article. Nothing of it is kept after the call
+    /// \return uint32_t    -> Ordinal of the article in the built index
+    uint32_t add(const Article &article);
+
+    /// \description        -> Spills what is left and merges the runs into the final index
+    void finish();
+
+    /// \return size_t      -> Number of runs spilled so far
+    size_t run_count() const { return runs_created; }
+
+    uint32_t doc_count() const { return next_ordinal; }
+};
+
+#endif //INC_22S_FINAL_PROJ_SPIMIBUILDER_H
@@ -0,0 +1,158 @@
+#include "UuidIndex.h"
+#include "IndexFile.h"
+
+#include <cstring>
+#include <stdexcept>
+
+/// \return int         -> Value of a lowercase hex digit, or -1
+static int hex_value(char digit) {
+    if (digit >= '0' && digit <= '9') return digit - '0';
+    if (digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+    return -1;
+}
+
+bool UuidIndex::pack(const std::string &id, Uuid &uuid) {
+    if (id.size() != 2 * uuid.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < uuid.size(); ++i) {
+        int high = hex_value(id[2 * i]);
+        int low = hex_value(id[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        uuid[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+size_t UuidIndex::home(const Uuid &uuid) const {
+    //Hashed uuids are uniform already; mixing keeps sequential, hand-made ones from clustering
+    uint64_t head, tail;
+    std::memcpy(&head, uuid.data(), sizeof(head));
+    std::memcpy(&tail, uuid.data() + uuid.size() - sizeof(tail), sizeof(tail));
+    uint64_t hash = head ^ tail * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ULL;
+    hash ^= hash >> 32;
+    return static_cast<size_t>(hash) & (slots.size() - 1);
+}
+
+size_t UuidIndex::locate(const Uuid &uuid) const {
+    size_t mask = slots.size() - 1;
+    size_t i = home(uuid);
+    while (slots[i].doc != NONE && slots[i].uuid != uuid) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void UuidIndex::grow() {
+    std::vector<Slot> old(slots.empty() ? 64 : 2 * slots.size(), Slot{{}, NONE});
+    old.swap(slots);
+    for (const Slot &slot: old) {
+        if (slot.doc != NONE) {
+            slots[locate(slot.uuid)] = slot;
+        }
+    }
+}
+
+DocId UuidIndex::find(const std::string &id) const {
+    Uuid uuid;
+    if (!pack(id, uuid)) {
+        auto entry = others.find(id);
+        return entry == others.end() ? NONE : entry->second;
+    }
+    return slots.empty() ? NONE : slots[locate(uuid)].doc;
+}
+
+DocId UuidIndex::assign(const std::string &id, DocId doc) {
+    Uuid uuid;
+    if (!pack(id, uuid)) {
+        auto [entry, inserted] = others.try_emplace(id, doc);
+        DocId previous = inserted ? NONE : entry->second;
+        entry->second = doc;
+        return previous;
+    }
+    //At most 3/4 full, so probes stay short
+    if (4 * (packed_count + 1) > 3 * slots.size()) {
+        grow();
+    }
+    Slot &slot = slots[locate(uuid)];
+    DocId previous = slot.doc;
+    if (previous == NONE) {
+        slot.uuid = uuid;
+        ++packed_count;
+    }
+    slot.doc = doc;
+    return previous;
+}
+
+DocId UuidIndex::erase(const std::string &id) {
+    Uuid uuid;
+    if (!pack(id, uuid)) {
+        auto entry = others.find(id);
+        if (entry == others.end()) {
+            return NONE;
+        }
+        DocId previous = entry->second;
+        others.erase(entry);
+        return previous;
+    }
+    if (slots.empty()) {
+        return NONE;
+    }
+    size_t hole = locate(uuid);
+    DocId previous = slots[hole].doc;
+    if (previous == NONE) {
+        return NONE;
+    }
+    //Shift back every following entry of the run whose probe passes over the hole
+    size_t mask = slots.size() - 1;
+    for (size_t i = (hole + 1) & mask; slots[i].doc != NONE; i = (i + 1) & mask) {
+        if (((i - home(slots[i].uuid)) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].doc = NONE;
+    --packed_count;
+    return previous;
+}
+
+void UuidIndex::save(const std::filesystem::path &path) const {
+    RecordWriter out(path, IndexFile::UUIDS_MAGIC);
+    out.put_block(slots.data(), slots.size() * sizeof(Slot), slots.size());
+    out.finish();
+}
+
+void UuidIndex::load(const std::filesystem::path &path) {
+    RecordReader in(path, IndexFile::UUIDS_MAGIC);
+    size_t count = in.size();
+    if ((count & (count - 1)) != 0) {
+        throw std::runtime_error("Not a valid index file: " + path.string());
+    }
+    slots.resize(count);
+    in.get_block(slots.data(), count * sizeof(Slot), count);
+    packed_count = 0;
+    for (const Slot &slot: slots) {
+        packed_count += slot.doc != NONE;
+    }
+}
+
+void UuidIndex::adopt(UuidIndex &&saved, const std::vector<DocId> &docs) {
+    if (packed_count != 0) {
+        throw std::logic_error("UuidIndex::adopt needs a table without packed uuids");
+    }
+    for (Slot &slot: saved.slots) {
+        if (slot.doc == NONE) {
+            continue;
+        }
+        if (slot.doc >= docs.size()) {
+            throw std::runtime_error("Index file has a uuid of a missing document");
+        }
+        slot.doc = docs[slot.doc];
+    }
+    slots.swap(saved.slots);
+    packed_count = saved.packed_count;
+}
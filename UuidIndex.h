@@ -0,0 +1,87 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       UuidIndex.h
+ * @date:           10-19-2026
+ * @description:    uuid -> DocId hash index of the live articles. A uuid (40 lowercase hex digits) is packed
+ *                  into 20 bytes and kept in an open-addressing table with linear probing, so a lookup costs
+ *                  one hash and a short probe, and never compares strings. Deletes shift the following
+ *                  entries back instead of leaving tombstones. Ids that are not 40 hex digits (hand-made
+ *                  feeds) fall back to a string map.
+ *                  The table can be saved as a block of fixed-size slots (IndexFile::UUIDS) and loaded
+ *                  without rehashing. It is not synchronized: the Index guards it.
+ */
+
+#ifndef INC_22S_FINAL_PROJ_UUIDINDEX_H
+#define INC_22S_FINAL_PROJ_UUIDINDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Segment.h"
+
+/// \description A uuid packed two hex digits per byte
+using Uuid = std::array<uint8_t, 20>;
+
+class UuidIndex {
+private:
+    struct Slot {
+        Uuid uuid;
+        //NONE when the slot is free
+        DocId doc;
+    };
+    static_assert(sizeof(Slot) == 24, "slots are saved as they are in memory");
+
+    //Power of two, or empty before the first insert
+    std::vector<Slot> slots;
+    size_t packed_count = 0;
+    std::unordered_map<std::string, DocId> others;
+
+    /// \return size_t      -> Slot the probe for "uuid" starts at
+    size_t home(const Uuid &uuid) const;
+
+    /// \return size_t      -> Slot holding "uuid", or the free slot its probe ends on. Needs a non-empty table
+    size_t locate(const Uuid &uuid) const;
+
+    /// \description        -> Doubles the table (64 slots the first time) and reinserts every entry
+    void grow();
+
+public:
+    static constexpr DocId NONE = UINT32_MAX;
+
+    /// \param id           -> Article id
+    /// \param uuid         -> Receives the packed id
+    /// \return bool        -> Whether "id" is 40 lowercase hex digits, the only ids that are packed
+    static bool pack(const std::string &id, Uuid &uuid);
+
+    /// \return DocId       -> Document "id" maps to, or NONE
+    DocId find(const std::string &id) const;
+
+    /// \param id           -> Article id
+    /// \param doc          -> Document it maps to from now on
+    /// \return DocId       -> Document it mapped to before, or NONE
+    DocId assign(const std::string &id, DocId doc);
+
+    /// \return DocId       -> Document "id" mapped to before it was removed, or NONE
+    DocId erase(const std::string &id);
+
+    /// \return size_t      -> Number of ids mapped
+    size_t size() const { return packed_count + others.size(); }
+
+    /// \param path         -> File to write; only packed uuids are saved
+    void save(const std::filesystem::path &path) const;
+
+    /// \param path         -> File written by save(); its entries replace the packed uuids of this table
+    void load(const std::filesystem::path &path);
+
+    /// \param saved        -> Loaded table whose documents are positions in "docs"
+    /// \param docs         -> Documents the positions stand for
+    /// \description        -> Takes over the packed uuids of "saved", mapped through "docs". This table must not
+    ///                     have packed uuids of its own; a position out of range throws
+    void adopt(UuidIndex &&saved, const std::vector<DocId> &docs);
+};
+
+#endif //INC_22S_FINAL_PROJ_UUIDINDEX_H
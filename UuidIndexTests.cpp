@@ -0,0 +1,168 @@
+/**
+ * @Author(s):      Pravin and Kassi
+ * @filename:       UuidIndexTests.cpp
+ * @date:           10-19-2026
+ * @description:    Tests of the uuid -> DocId table: probe runs that wrap past the last slot, deletes that shift
+ *                  entries back across the wrap, and the save -> load -> adopt round trip of a saved index.
+ */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "UuidIndex.h"
+
+/// \description The first table holds 64 slots, and stays that size up to 48 uuids
+static constexpr size_t FIRST_SLOTS = 64;
+
+/// \param uuid         -> Packed uuid
+/// \return size_t      -> Slot its probe starts at in a table of FIRST_SLOTS (the hash of UuidIndex::home)
+static size_t first_home(const Uuid &uuid) {
+    uint64_t head, tail;
+    std::memcpy(&head, uuid.data(), sizeof(head));
+    std::memcpy(&tail, uuid.data() + uuid.size() - sizeof(tail), sizeof(tail));
+    uint64_t hash = head ^ tail * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ULL;
+    hash ^= hash >> 32;
+    return static_cast<size_t>(hash) & (FIRST_SLOTS - 1);
+}
+
+/// \param slot         -> Home slot wanted
+/// \param count        -> Number of uuids wanted
+/// \param from         -> Counter the search starts at, advanced past the uuids found
+/// \return vector      -> "count" distinct 40-hex-digit ids whose probe starts at "slot"
+static std::vector<std::string> ids_at(size_t slot, size_t count, uint64_t &from) {
+    std::vector<std::string> ids;
+    while (ids.size() < count) {
+        char id[41];
+        std::snprintf(id, sizeof(id), "%024x%016llx", 0xfeedu, static_cast<unsigned long long>(from++));
+        Uuid uuid;
+        if (UuidIndex::pack(id, uuid) && first_home(uuid) == slot) ids.emplace_back(id);
+    }
+    return ids;
+}
+
+TEST_CASE("UuidIndex probe runs that wrap around the table", "[UuidIndex]") {
+    //1- A run starting on the last slot spills into the first ones, where a run of slot 0 continues it
+    uint64_t counter = 0;
+    std::vector<std::string> last = ids_at(FIRST_SLOTS - 1, 4, counter);
+    std::vector<std::string> first = ids_at(0, 2, counter);
+    std::vector<std::string> before = ids_at(FIRST_SLOTS - 2, 2, counter);
+    UuidIndex index;
+    DocId doc = 0;
+    for (const std::vector<std::string> *ids: {&last, &first, &before}) {
+        for (const std::string &id: *ids) {
+            REQUIRE(index.assign(id, doc++) == UuidIndex::NONE);
+        }
+    }
+    REQUIRE(index.size() == 8);
+
+    SECTION("every id is found, and assigning it again replaces its document") {
+        doc = 0;
+        for (const std::vector<std::string> *ids: {&last, &first, &before}) {
+            for (const std::string &id: *ids) {
+                CHECK(index.find(id) == doc++);
+            }
+        }
+        CHECK(index.assign(first[1], 77) == 5);
+        CHECK(index.find(first[1]) == 77);
+        CHECK(index.size() == 8);
+    }
+
+    SECTION("erasing ahead of the wrap shifts the rest of the run back") {
+        CHECK(index.erase(before[0]) == 6);
+        CHECK(index.erase(last[0]) == 0);
+        CHECK(index.erase(last[0]) == UuidIndex::NONE);
+        CHECK(index.find(last[0]) == UuidIndex::NONE);
+        CHECK(index.find(before[0]) == UuidIndex::NONE);
+        CHECK(index.size() == 6);
+        for (size_t i = 1; i < last.size(); ++i) CHECK(index.find(last[i]) == i);
+        CHECK(index.find(first[0]) == 4);
+        CHECK(index.find(first[1]) == 5);
+        CHECK(index.find(before[1]) == 7);
+    }
+
+    SECTION("erasing past the wrap keeps the entries that home before it") {
+        CHECK(index.erase(first[0]) == 4);
+        CHECK(index.erase(last[3]) == 3);
+        CHECK(index.find(first[1]) == 5);
+        for (size_t i = 0; i < 3; ++i) CHECK(index.find(last[i]) == i);
+        CHECK(index.assign(first[0], 40) == UuidIndex::NONE);
+        CHECK(index.find(first[0]) == 40);
+        CHECK(index.size() == 7);
+    }
+
+    SECTION("erasing the whole run empties the table") {
+        for (const std::vector<std::string> *ids: {&first, &last, &before}) {
+            for (const std::string &id: *ids) {
+                CHECK(index.erase(id) != UuidIndex::NONE);
+            }
+        }
+        CHECK(index.size() == 0);
+        CHECK(index.find(last[0]) == UuidIndex::NONE);
+    }
+}
+
+TEST_CASE("UuidIndex ids that are not 40 hex digits", "[UuidIndex]") {
+    UuidIndex index;
+    CHECK(index.assign("hand-made-1", 3) == UuidIndex::NONE);
+    CHECK(index.assign("HAND-MADE-1", 4) == UuidIndex::NONE);
+    CHECK(index.assign("hand-made-1", 5) == 3);
+    CHECK(index.find("hand-made-1") == 5);
+    CHECK(index.erase("HAND-MADE-1") == 4);
+    CHECK(index.find("HAND-MADE-1") == UuidIndex::NONE);
+    CHECK(index.size() == 1);
+}
+
+TEST_CASE("UuidIndex save, load and adopt", "[UuidIndex]") {
+    //1- Save a table of 100 uuids (grown twice) mapped to their positions, one of them erased
+    uint64_t counter = 0;
+    std::vector<std::string> ids;
+    UuidIndex saved;
+    for (DocId position = 0; position < 100; ++position) {
+        ids.push_back(ids_at(position % FIRST_SLOTS, 1, counter).front());
+        saved.assign(ids.back(), position);
+    }
+    saved.erase(ids[17]);
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "googleyes-uuid-test.dat";
+    saved.save(path);
+
+    //2- Load it and map the positions to the documents they became
+    UuidIndex loaded;
+    loaded.load(path);
+    CHECK(loaded.size() == 99);
+    std::vector<DocId> docs;
+    for (DocId position = 0; position < 100; ++position) docs.push_back(1000 + 2 * position);
+
+    SECTION("adopted uuids find the mapped documents, next to the ids that are not packed") {
+        UuidIndex index;
+        index.assign("hand-made-1", 9);
+        index.adopt(std::move(loaded), docs);
+        CHECK(index.size() == 100);
+        for (DocId position = 0; position < 100; ++position) {
+            CHECK(index.find(ids[position]) == (position == 17 ? UuidIndex::NONE : docs[position]));
+        }
+        CHECK(index.find("hand-made-1") == 9);
+        CHECK(index.erase(ids[18]) == docs[18]);
+        CHECK(index.assign(ids[17], 5) == UuidIndex::NONE);
+        CHECK(index.find(ids[17]) == 5);
+    }
+
+    SECTION("a position past the documents throws") {
+        docs.resize(50);
+        UuidIndex index;
+        CHECK_THROWS_AS(index.adopt(std::move(loaded), docs), std::runtime_error);
+    }
+
+    SECTION("a table with packed uuids of its own cannot adopt") {
+        UuidIndex index;
+        index.assign(ids[0], 1);
+        CHECK_THROWS_AS(index.adopt(std::move(loaded), docs), std::logic_error);
+    }
+    std::filesystem::remove(path);
+}
@@ -1,14 +1,276 @@
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include "CpuTopology.h"
+#include "Facets.h"
+#include "FeedIngestor.h"
+#include "Metadata.h"
 #include "Parser.h"
 #include "Query.h"
+#include "Snippet.h"
 #include "Article.h"
+#include "catch_setup.h"
+
+/// \description Search results printed per page
+static constexpr size_t PAGE_SIZE = 25;
+static constexpr size_t FACET_COUNT = 5;
+
+/// \description        -> Prints the command line flags
+static void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " [--threads N] [--cpus LIST] [--pin none|core|node]\n"
+              << "       [--feed PATH | --feed - --index-out DIR] [--spool DIR] [--refresh-ms N]\n"
+              << "       [--load DIR] [--build DATASET --index-out DIR [--budget-mb N]] [--no-positions]\n"
+              << "       [--title-boost X] [--cache-entries N] [--filter-cache-mb N] [--partition day|week|month]\n"
+              << "       [--facet-sample N] [--query-threads N]\n"
+              << "       " << program << " --test\n"
+              << "  --threads N     number of ingest workers (default: one per CPU in --cpus)\n"
+              << "  --cpus LIST     CPUs the ingest pool may use, e.g. 0-3,8 (default: all)\n"
+              << "  --pin MODE      pin each worker to one core, to its NUMA node, or not at all\n"
+              << "  --query-threads N  run searches on a pool of N workers, on the last N CPUs of --cpus; ingest\n"
+              << "                  keeps the others (default 0: searches run on the menu thread)\n"
+              << "  --feed PATH     index JSON lines from a file or named pipe while the menu runs;\n"
+              << "                  \"-\" reads stdin until EOF, saves the index to --index-out DIR and exits\n"
+              << "                  (no menu)\n"
+              << "  --spool DIR     index new .json files dropped into DIR while the menu runs\n"
+              << "  --refresh-ms N  how often fed articles become searchable (default 1000)\n"
+              << "  --load DIR      load a saved index directory before the menu starts\n"
+              << "  --build DATASET index DATASET into --index-out DIR with bounded memory and exit\n"
+              << "  --budget-mb N   memory for the --build dictionary before it spills to disk (default 256)\n"
+              << "  --no-positions  do not index word positions (smaller index, no phrase queries)\n"
+              << "  --title-boost X weight of a title match relative to a text match when ranking (default 3)\n"
+              << "  --cache-entries N  search results kept for repeat queries (default 1024, 0 disables)\n"
+              << "  --filter-cache-mb N  memory for the bitmaps of popular ORG/PERSON and date/site/lang filters\n"
+              << "                  (default 64)\n"
+              << "  --partition P   keep one segment per day, week or month of publication, so searches with a\n"
+              << "                  date: filter skip the other periods\n"
+              << "  --facet-sample N  most results whose organizations and persons are counted for the top\n"
+              << "                  entities shown with a search; larger result sets are sampled (default 100000)\n"
+              << "  --test          run the unit tests and exit\n";
+}
+
+/// \param text         -> Command line value
+/// \return size_t      -> The non-negative integer "text" spells out in full. Throws std::invalid_argument otherwise
+static size_t parse_count(const std::string &text) {
+    size_t used = 0;
+    if (text.empty() || text[0] == '-') throw std::invalid_argument("not a count: " + text);
+    size_t value = std::stoul(text, &used);
+    if (used != text.size()) throw std::invalid_argument("not a count: " + text);
+    return value;
+}
+
+/// \param text         -> Command line value
+/// \return double      -> The number "text" spells out in full. Throws std::invalid_argument otherwise
+static double parse_number(const std::string &text) {
+    size_t used = 0;
+    double value = std::stod(text, &used);
+    if (used != text.size()) throw std::invalid_argument("not a number: " + text);
+    return value;
+}
+
+/// \param article      -> Fetched article
+/// \return string      -> " (site, date, language)" with the parts the article has, or nothing
+static std::string describe_source(const Article &article) {
+    std::vector<std::string> parts;
+    if (!article.site.empty()) parts.push_back(article.site);
+    if (article.published != UNKNOWN_DATE) parts.push_back(Metadata::format_date(article.published));
+    if (!article.language.empty()) parts.push_back(article.language);
+    std::string source;
+    for (const std::string &part: parts) {
+        source += (source.empty() ? " (" : ", ") + part;
+    }
+    return source.empty() ? source : source + ')';
+}
+
+/// \param label        -> What the entities are, e.g. "Top organizations"
+/// \param facets       -> Top entities of the results
+/// \return string      -> "label: name (count), ..." on one line; "~" marks counts estimated from a sample
+static std::string describe_facets(const char *label, const FacetCounts &facets) {
+    std::string line = label;
+    line += ':';
+    for (const Facet &facet: facets.top) {
+        line += (&facet == &facets.top.front() ? " " : ", ") + facet.name + " (" +
+                (facets.counted < facets.matches ? "~" : "") + std::to_string(facet.count) + ')';
+    }
+    return facets.top.empty() ? line + " none" : line;
+}
 
 int main(int argc, char **argv) {
+    if (argc == 2 && std::strcmp(argv[1], "--test") == 0) {
+        return runCatchTests();
+    }
+    //Ingest pool configuration, and the CPUs it leaves to a query pool
+    size_t threads = 0;
+    size_t query_threads = 0;
+    std::vector<int> cpus;
+    Pinning pinning = Pinning::NONE;
+    FeedConfig feed_config;
+    std::string load_path, build_path, index_output;
+    SpimiConfig spimi_config;
+    IndexConfig index_config;
+    double title_boost = 3;
+    size_t cache_entries = 1024;
+    size_t filter_cache_bytes = size_t(64) << 20;
+    size_t facet_sample = FacetCounter::DEFAULT_SAMPLE_LIMIT;
+    //Malformed values (not a number, an unknown mode) end up here, like unknown options
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threads = parse_count(argv[++i]);
+            } else if (std::strcmp(argv[i], "--query-threads") == 0 && i + 1 < argc) {
+                query_threads = parse_count(argv[++i]);
+            } else if (std::strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+                cpus = CpuTopology::parse_cpu_list(argv[++i]);
+            } else if (std::strcmp(argv[i], "--pin") == 0 && i + 1 < argc) {
+                std::string mode = argv[++i];
+                if (mode != "none" && mode != "core" && mode != "node") throw std::invalid_argument("pin: " + mode);
+                pinning = mode == "core" ? Pinning::CORE : mode == "node" ? Pinning::NODE : Pinning::NONE;
+            } else if (std::strcmp(argv[i], "--feed") == 0 && i + 1 < argc) {
+                feed_config.feed_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--spool") == 0 && i + 1 < argc) {
+                feed_config.spool_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--refresh-ms") == 0 && i + 1 < argc) {
+                //A zero interval would have the refresh thread flush without pause
+                size_t interval = parse_count(argv[++i]);
+                if (interval == 0) throw std::invalid_argument("refresh interval must be positive");
+                feed_config.refresh_interval = std::chrono::milliseconds(interval);
+            } else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+                load_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--build") == 0 && i + 1 < argc) {
+                build_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--index-out") == 0 && i + 1 < argc) {
+                index_output = argv[++i];
+            } else if (std::strcmp(argv[i], "--budget-mb") == 0 && i + 1 < argc) {
+                spimi_config.memory_budget = parse_count(argv[++i]) << 20;
+            } else if (std::strcmp(argv[i], "--no-positions") == 0) {
+                index_config.positions = false;
+                spimi_config.positions = false;
+            } else if (std::strcmp(argv[i], "--title-boost") == 0 && i + 1 < argc) {
+                title_boost = parse_number(argv[++i]);
+            } else if (std::strcmp(argv[i], "--cache-entries") == 0 && i + 1 < argc) {
+                cache_entries = parse_count(argv[++i]);
+            } else if (std::strcmp(argv[i], "--filter-cache-mb") == 0 && i + 1 < argc) {
+                filter_cache_bytes = parse_count(argv[++i]) << 20;
+            } else if (std::strcmp(argv[i], "--facet-sample") == 0 && i + 1 < argc) {
+                facet_sample = parse_count(argv[++i]);
+            } else if (std::strcmp(argv[i], "--partition") == 0 && i + 1 < argc) {
+                std::string period = argv[++i];
+                if (period != "day" && period != "week" && period != "month") {
+                    throw std::invalid_argument("partition: " + period);
+                }
+                index_config.partitioning = period == "day" ? Partition::DAY : period == "week" ? Partition::WEEK
+                                                                                                : Partition::MONTH;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception &) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    //--index-out is where --build and a headless feed write their index: each needs it, nothing else takes it
+    bool headless = feed_config.feed_path == "-";
+    if (index_output.empty() == (!build_path.empty() || headless) || (!build_path.empty() && headless)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    CpuTopology topology = CpuTopology::detect();
+    std::vector<int> ingest_cpus = cpus.empty() ? topology.all_cpus() : cpus;
+    std::vector<int> query_cpus;
+    if (query_threads != 0) {
+        //Disjoint sets, so searches never wait for a core an ingest worker holds. Both need at least one CPU
+        std::tie(ingest_cpus, query_cpus) = topology.split(ingest_cpus, ingest_cpus.size() - std::min(
+                query_threads, ingest_cpus.size()));
+        if (ingest_cpus.empty() || query_cpus.empty()) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    ThreadPool ingest_pool(topology.pool_config(ingest_cpus, threads, pinning));
+    std::unique_ptr<ThreadPool> query_pool;
+    if (!query_cpus.empty()) {
+        query_pool = std::make_unique<ThreadPool>(topology.pool_config(query_cpus, query_threads, pinning));
+    }
+    //Runs a search (and the printing of its results) on the query pool, or right here without one
+    auto on_query_pool = [&query_pool](auto &&work) {
+        if (query_pool == nullptr) {
+            work();
+        } else {
+            query_pool->enqueue(work).get();
+        }
+    };
 
     char option;
-    AvlTree<std::string, Article *> article_tree;
-    Parser parser;
-    std::vector<ArticlePair> pairs;
+    Index index(index_config);
+    Parser parser(ingest_pool);
+
+    if (!build_path.empty()) {
+        //Headless external-memory build: nothing but the dictionary budget and one parse batch in RAM
+        SpimiBuilder builder(index_output, spimi_config);
+        parser.build_external(build_path, builder);
+        std::cout << "Indexed " << builder.doc_count() << " articles into " << index_output << " ("
+                  << builder.run_count() << " runs spilled)\n";
+        return 0;
+    }
+    if (!load_path.empty()) {
+        try {
+            index.load(load_path);
+        } catch (const std::exception &error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+    }
+
+    std::unique_ptr<FeedIngestor> feed;
+    if (!feed_config.feed_path.empty() || !feed_config.spool_path.empty()) {
+        feed = std::make_unique<FeedIngestor>(feed_config, index, ingest_pool);
+    }
+    if (headless) {
+        //Headless mode: stdin carries the feed, not menu options, and the index it builds is saved
+        while (!feed->finished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        feed->stop();
+        try {
+            index.save(index_output);
+        } catch (const std::exception &error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        std::cout << "Indexed " << feed->ingested() << " articles into " << index_output << " ("
+                  << feed->malformed() << " malformed records skipped, " << feed->retracted() << " retracted)\n";
+        return 0;
+    }
+    //Last search, the generation it runs on and its current page; option 7 moves to the next page
+    std::unique_ptr<Query> search;
+    std::shared_ptr<const IndexGeneration> search_generation;
+    ResultPage page;
+    size_t shown = 0;
+    //Result pages of repeat searches, until the index publishes a new generation
+    PageCache result_cache(cache_entries);
+    //Bitmaps of the ORG/PERSON filters that keep coming back, shared by every search
+    FilterCache filter_cache(filter_cache_bytes);
+
+    //Fetches the articles of the current page, and only those, from the document store and prints them with a
+    //snippet of their text around the query's words
+    auto show_page = [&]() {
+        std::vector<std::string> terms = search->highlighted_terms(Field::TEXT);
+        for (const ScoredDoc &hit: page.hits) {
+            Article article = index.fetch(hit.id);
+            std::cout << article.id << ": " << article.title << describe_source(article) << '\n';
+            std::cout << "    " << Snippet::build(article.text, terms) << '\n';
+        }
+        if (page.hits.empty()) {
+            std::cout << "No results\n";
+            return;
+        }
+        std::cout << "Results " << shown + 1 << "-" << shown + page.hits.size() << " of " << page.total
+                  << (page.more ? " (option 7 shows the next page)" : "") << '\n';
+        shown += page.hits.size();
+    };
 
     do {
         std::cout << "\n---GOOGLEYES SEARCH ENGINE---\n";
@@ -19,10 +281,14 @@ int main(int argc, char **argv) {
         std::cout << "3 - Display Engine Statistics" << '\n';
         std::cout << "4 - Search Dataset" << '\n';
         std::cout << "5 - Display Article Info" << '\n';
+        std::cout << "7 - Next Page of Results" << '\n';
         std::cout << "6 - Quit" << '\n';
 
         std::cout << "Enter option: ";
-        std::cin >> option;
+        if (!(std::cin >> option)) {
+            //End of input behaves like Quit
+            option = '6';
+        }
 
         switch (option) {
             case '0': {
@@ -31,32 +297,68 @@ int main(int argc, char **argv) {
                 std::string folder_path;
                 std::cin >> folder_path;
 
+                //Parsing again adds the new articles to the existing index
                 parser.parse(folder_path);
 
-                article_tree = parser.build_AVL_tree();
+                parser.build_index(index);
                 break;
             }
 
             case '1': {
-                article_tree.form_persistent_file();
+                //Save the index
+                std::cout << "Enter index directory: ";
+                std::string directory;
+                std::cin >> directory;
+                try {
+                    index.save(directory);
+                    std::cout << "Index saved, load it with --load " << directory << '\n';
+                } catch (const std::exception &error) {
+                    std::cout << error.what() << '\n';
+                }
                 break;
             }
 
             case '2': {
-                article_tree.clear_persistent_file();
+                //Remove a saved index
+                std::cout << "Enter index directory: ";
+                std::string directory;
+                std::cin >> directory;
+                std::error_code error;
+                std::filesystem::remove(std::filesystem::path(directory) / IndexFile::DOCUMENTS, error);
+                std::filesystem::remove(std::filesystem::path(directory) / IndexFile::TERMS, error);
+                std::filesystem::remove(std::filesystem::path(directory) / IndexFile::UUIDS, error);
+                std::filesystem::remove(directory, error);
                 break;
             }
 
             case '3': {
                 //Display statistics
-                std::cout << "\nTotal articles indexed is: " << article_tree.get_total_articles() << '\n';
-                std::cout << "Total Unique Words (Excluding Stop Words): " << article_tree.size() << '\n';
-                std::cout << "Unique Organizations: " << parser.k1.size() << '\n';
-                std::cout << "Unique Persons: " << parser.k2.size() << '\n';
-                std::cout << "Word-Article Ratio (Stop words excluded): " << article_tree.get_word_article_ratio()
+                IndexSnapshot generation = index.snapshot();
+                std::vector<Pair> statistics = Index::term_statistics(*generation);
+                std::cout << "\nTotal articles indexed is: " << generation->doc_count() << '\n';
+                std::cout << "Index segments: " << generation->segments.size() << '\n';
+                std::cout << "Total Unique Words (Excluding Stop Words): " << statistics.size() << '\n';
+                std::cout << "Unique Organizations: " << index.entities().size(Entity::ORGANIZATION) << '\n';
+                std::cout << "Unique Persons: " << index.entities().size(Entity::PERSON) << '\n';
+                std::cout << "Result cache: " << result_cache.hits() << " hits, " << result_cache.misses()
+                          << " misses\n";
+                std::cout << "Filter cache: " << filter_cache.hits() << " hits, " << filter_cache.misses()
+                          << " misses, " << filter_cache.size() << " bytes\n";
+                std::cout << "Document store: " << index.documents().size() << " bytes compressed to "
+                          << index.documents().stored_size() << " on disk, " << index.documents().hits()
+                          << " block cache hits, " << index.documents().misses() << " misses\n";
+                std::cout << "Word-Article Ratio (Stop words excluded): " << index.get_word_article_ratio()
                           << '\n';
+                if (feed) {
+                    std::cout << "Articles ingested from the feed: " << feed->ingested() << " ("
+                              << feed->malformed() << " malformed, " << feed->retracted() << " retracted)\n";
+                }
                 std::cout << "TOP 25 Most frequent words (Descending): \n";
-                article_tree.proposition_279();
+                std::priority_queue<Pair> p_queue(statistics.begin(), statistics.end());
+                for (int i = 0; i < 25 && !p_queue.empty(); i++) {
+                    std::cout << p_queue.top().word << " -> " << p_queue.top().articles << '\n';
+                    p_queue.pop();
+                }
                 break;
             }
 
@@ -66,23 +368,71 @@ int main(int argc, char **argv) {
                 std::string search_request;
                 std::cin.ignore();
                 std::getline(std::cin, search_request);
-                pairs = {};
-                Query query(search_request);
-                std::set<Article *> articles = query.get_elements(article_tree, parser.person_map, parser.orgs_map);
-                std::cout << "\n---Search performed in: " << query.get_query_processing_time() << " second(s)---\n";
-                for (Article *article: articles) {
-                    pairs.push_back({.article = article, .weight = query.frequency(article->tokens)});
-                }
-                std::sort(pairs.begin(), pairs.end());
-                int n = 0;
-                for (const ArticlePair &pair: pairs) {
-                    std::cout << pair.article->id << ": " << pair.article->title << '\n';
-                    if (n == 25) break;
-                    ++n;
-                }
-                if (n == 25) {
-                    std::cout << "Limited to the top 25 Results\n";
+                //"EXPLAIN <query>" prints the plan and its measurements before the results. "COUNT <query>" and
+                //"ESTIMATE <query>" only tell how many articles match, exactly or from a 5% sample
+                auto prefixed = [&search_request](const char *prefix) {
+                    bool found = search_request.rfind(prefix, 0) == 0;
+                    if (found) {
+                        search_request.erase(0, std::strlen(prefix));
+                    }
+                    return found;
+                };
+                bool explain = prefixed("EXPLAIN ");
+                bool count_only = prefixed("COUNT ");
+                bool estimate = !count_only && prefixed("ESTIMATE ");
+                auto query = std::make_unique<Query>(search_request);
+                query->set_boost(Field::TITLE, title_boost);
+                query->set_filter_cache(&filter_cache);
+                on_query_pool([&] {
+                    IndexSnapshot generation = index.snapshot();
+                    if (explain) {
+                        std::cout << '\n' << query->explain(*generation);
+                    }
+                    if (count_only) {
+                        size_t matches = query->count(*generation);
+                        std::cout << "\n" << matches << " matching article(s), counted in "
+                                  << query->get_query_processing_time() << " second(s)\n";
+                        return;
+                    }
+                    if (estimate) {
+                        CountEstimate matches = query->estimate_count(*generation);
+                        std::cout << '\n' << (matches.exact ? "" : "~") << matches.count << " matching article(s)";
+                        if (!matches.exact) {
+                            std::cout << " (95% between " << matches.low << " and " << matches.high << ")";
+                        }
+                        std::cout << ", estimated in " << query->get_query_processing_time() << " second(s)\n";
+                        return;
+                    }
+                    //Ranked a page at a time: only the page's hits are kept and loaded
+                    search = std::move(query);
+                    search_generation = generation.retain();
+                    page = search->get_page(*search_generation, PAGE_SIZE, nullptr, &result_cache);
+                    shown = 0;
+                    std::cout << "\n---Search performed in: " << search->get_query_processing_time()
+                              << " second(s)---\n";
+                    show_page();
+                    //Entities the whole result set is tagged with, not only the page
+                    if (page.total != 0) {
+                        auto facets = search->facets(*search_generation, FACET_COUNT, facet_sample);
+                        std::cout << describe_facets("Top organizations",
+                                                     facets[static_cast<size_t>(Entity::ORGANIZATION)]) << '\n';
+                        std::cout << describe_facets("Top persons",
+                                                     facets[static_cast<size_t>(Entity::PERSON)]) << '\n';
+                    }
+                });
+                break;
+            }
+
+            case '7': {
+                if (search == nullptr || !page.more) {
+                    std::cout << "No more results\n";
+                    break;
                 }
+                ScoredDoc after = page.hits.back();
+                on_query_pool([&] {
+                    page = search->get_page(*search_generation, PAGE_SIZE, &after, &result_cache);
+                    show_page();
+                });
                 break;
             }
 
@@ -90,13 +440,15 @@ int main(int argc, char **argv) {
                 std::cout << "Enter Article ID: ";
                 std::string id;
                 std::cin >> id;
-                for (const ArticlePair &pair: pairs) {
-                    if (pair.article->id == id) {
-                        std::cout << "\nTitle: " << pair.article->title << '\n';
-                        std::cout << "\nText: " << pair.article->text << '\n';
-                        break;
-                    }
+                //Any live article, whether or not it was in the results
+                DocId doc = index.find(id);
+                if (doc == UuidIndex::NONE) {
+                    std::cout << "No article with that ID\n";
+                    break;
                 }
+                Article article = index.fetch(doc);
+                std::cout << "\nTitle: " << article.title << describe_source(article) << '\n';
+                std::cout << "\nText: " << article.text << '\n';
                 break;
             }
 
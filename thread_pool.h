@@ -1,8 +1,8 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <algorithm>
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -10,87 +10,637 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Work-stealing thread pool.
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops at the bottom, idle workers steal from
+// the top. Threads that are not part of the pool submit through a bounded lock-free injection queue.
+// Tasks live in fixed-size nodes with inline storage for the callable, and nodes are recycled
+// through per-thread caches, so steady-state submission does not touch the allocator. Idle workers
+// park on a futex (condition variable on other platforms) and are only woken when someone is parked.
+namespace thread_pool_detail {
+
+constexpr size_t CACHE_LINE = 64;
+
+// A type-erased, move-only unit of work with small-buffer storage
+struct alignas(CACHE_LINE) TaskNode {
+    static constexpr size_t INLINE_SIZE = 2 * CACHE_LINE - 2 * alignof(std::max_align_t);
+
+    TaskNode *next = nullptr;
+    void (*invoke)(TaskNode *) = nullptr;
+    void (*destroy)(TaskNode *) = nullptr;
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+
+    template<class F>
+    static constexpr bool fits_inline() {
+        return sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t);
+    }
+
+    template<class F>
+    void emplace(F &&f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>()) {
+            new(storage) Fn(std::forward<F>(f));
+            invoke = [](TaskNode *node) { (*std::launder(reinterpret_cast<Fn *>(node->storage)))(); };
+            destroy = [](TaskNode *node) { std::launder(reinterpret_cast<Fn *>(node->storage))->~Fn(); };
+        } else {
+            // oversized callables fall back to the heap
+            *reinterpret_cast<Fn **>(storage) = new Fn(std::forward<F>(f));
+            invoke = [](TaskNode *node) { (**reinterpret_cast<Fn **>(node->storage))(); };
+            destroy = [](TaskNode *node) { delete *reinterpret_cast<Fn **>(node->storage); };
+        }
+    }
+
+    void run() {
+        invoke(this);
+        destroy(this);
+    }
+};
+
+static_assert(sizeof(TaskNode) == 2 * CACHE_LINE, "task nodes should span exactly two cache lines");
+
+// Process-wide recycler for task nodes. Each thread keeps a small private cache, overflow is
+// pushed to a shared lock-free stack in one CAS, and refills take the whole shared stack at once
+// (exchange), which makes the stack immune to ABA without tagged pointers.
+class TaskNodeAllocator {
+public:
+    static TaskNode *allocate() {
+        LocalCache &cache = local_cache();
+        if (cache.head == nullptr) {
+            cache.head = shared_head().exchange(nullptr, std::memory_order_acquire);
+            cache.count = 0;
+            for (TaskNode *node = cache.head; node != nullptr; node = node->next) ++cache.count;
+        }
+        if (cache.head == nullptr) {
+            return new TaskNode();
+        }
+        TaskNode *node = cache.head;
+        cache.head = node->next;
+        --cache.count;
+        return node;
+    }
+
+    static void release(TaskNode *node) {
+        LocalCache &cache = local_cache();
+        node->next = cache.head;
+        cache.head = node;
+        if (++cache.count > LOCAL_LIMIT) {
+            cache.spill(LOCAL_LIMIT / 2);
+        }
+    }
+
+private:
+    static constexpr size_t LOCAL_LIMIT = 256;
+
+    struct LocalCache {
+        TaskNode *head = nullptr;
+        size_t count = 0;
+
+        // hand "keep"-exceeding nodes to the shared stack
+        void spill(size_t keep) {
+            TaskNode *last = head;
+            for (size_t i = 1; i < keep && last != nullptr; ++i) last = last->next;
+            if (last == nullptr || last->next == nullptr) return;
+            TaskNode *chain = last->next;
+            last->next = nullptr;
+            TaskNode *tail = chain;
+            while (tail->next != nullptr) tail = tail->next;
+            count = keep;
+            std::atomic<TaskNode *> &shared = shared_head();
+            TaskNode *expected = shared.load(std::memory_order_relaxed);
+            do {
+                tail->next = expected;
+            } while (!shared.compare_exchange_weak(expected, chain, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+        }
+
+        ~LocalCache() { spill_all(); }
+
+        void spill_all() {
+            if (head == nullptr) return;
+            TaskNode *tail = head;
+            while (tail->next != nullptr) tail = tail->next;
+            std::atomic<TaskNode *> &shared = shared_head();
+            TaskNode *expected = shared.load(std::memory_order_relaxed);
+            do {
+                tail->next = expected;
+            } while (!shared.compare_exchange_weak(expected, head, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+            head = nullptr;
+            count = 0;
+        }
+    };
+
+    static LocalCache &local_cache() {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    // nodes are never returned to the system; the pool only grows to the peak number of tasks in flight
+    static std::atomic<TaskNode *> &shared_head() {
+        static std::atomic<TaskNode *> head{nullptr};
+        return head;
+    }
+};
+
+// Chase-Lev work-stealing deque ("Correct and Efficient Work-Stealing for Weak Memory Models",
+// Le et al. 2013). Only the owning worker calls push/pop, any thread may call steal.
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity = 1024) : array(new Array(capacity)) {}
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    ~WorkStealingDeque() {
+        delete array.load(std::memory_order_relaxed);
+        for (Array *old: retired) delete old;
+    }
+
+    void push(TaskNode *node) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array *a = array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            a = grow(a, b, t);
+        }
+        a->put(b, node);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    TaskNode *pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        TaskNode *node = nullptr;
+        if (t <= b) {
+            node = a->get(b);
+            if (t == b) {
+                // last element: race against thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    node = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    TaskNode *steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t < b) {
+            Array *a = array.load(std::memory_order_acquire);
+            TaskNode *node = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return node;
+        }
+        return nullptr;
+    }
+
+    bool empty() const {
+        int64_t t = top.load(std::memory_order_acquire);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        return b <= t;
+    }
+
+private:
+    struct Array {
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<TaskNode *>[]> slots;
+
+        explicit Array(size_t capacity) : capacity(capacity), mask(capacity - 1),
+                                          slots(new std::atomic<TaskNode *>[capacity]) {}
+
+        // release/acquire on the slot publishes the node's contents to whoever takes it
+        TaskNode *get(int64_t i) const { return slots[i & mask].load(std::memory_order_acquire); }
+
+        void put(int64_t i, TaskNode *node) { slots[i & mask].store(node, std::memory_order_release); }
+    };
+
+    Array *grow(Array *a, int64_t b, int64_t t) {
+        Array *bigger = new Array(a->capacity * 2);
+        for (int64_t i = t; i < b; ++i) bigger->put(i, a->get(i));
+        // thieves may still be reading the old array, keep it until the deque dies
+        retired.push_back(a);
+        array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(CACHE_LINE) std::atomic<int64_t> top{0};
+    alignas(CACHE_LINE) std::atomic<int64_t> bottom{0};
+    alignas(CACHE_LINE) std::atomic<Array *> array;
+    std::vector<Array *> retired;
+};
+
+// Bounded multi-producer/multi-consumer queue (D. Vyukov). Used for submissions from threads that
+// are not workers of the pool.
+class InjectionQueue {
+public:
+    explicit InjectionQueue(size_t capacity) : mask(capacity - 1), cells(new Cell[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(TaskNode *node) {
+        Cell *cell;
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->node = node;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    TaskNode *pop() {
+        Cell *cell;
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        TaskNode *node = cell->node;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return node;
+    }
+
+    bool empty() const {
+        return dequeue_pos.load(std::memory_order_acquire) >= enqueue_pos.load(std::memory_order_acquire);
+    }
+
+private:
+    struct alignas(CACHE_LINE) Cell {
+        std::atomic<size_t> sequence;
+        TaskNode *node;
+    };
+
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos{0};
+    alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos{0};
+};
+
+// Event count for parking idle workers. A worker announces itself with prepare_wait, re-checks
+// every queue and only then sleeps; producers skip the syscall entirely when nobody is parked.
+class Parker {
+public:
+    uint32_t prepare_wait() {
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    void cancel_wait() { sleepers.fetch_sub(1, std::memory_order_seq_cst); }
+
+    void commit_wait(uint32_t observed) {
+#ifdef __linux__
+        while (epoch.load(std::memory_order_acquire) == observed) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch), FUTEX_WAIT_PRIVATE, observed,
+                    nullptr, nullptr, 0);
+        }
+#else
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return epoch.load(std::memory_order_acquire) != observed; });
+#endif
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void notify(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) == 0) return;
+#ifdef __linux__
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1,
+                nullptr, nullptr, 0);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (all) condition.notify_all(); else condition.notify_one();
+#endif
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+    alignas(CACHE_LINE) std::atomic<uint32_t> epoch{0};
+    alignas(CACHE_LINE) std::atomic<uint32_t> sleepers{0};
+#ifndef __linux__
+    std::mutex mutex;
+    std::condition_variable condition;
+#endif
+};
+
+} // namespace thread_pool_detail
+
+// How many workers to start and where they may run (see CpuTopology.h for builders)
+struct ThreadPoolConfig {
+    // 0 means std::thread::hardware_concurrency()
+    size_t threads = 0;
+    // worker i is pinned to worker_cpus[i]; missing or empty entries leave a worker unpinned
+    std::vector<std::vector<int>> worker_cpus;
+    // NUMA node of worker i; workers steal from their own node before crossing nodes
+    std::vector<int> worker_nodes;
+};
 
 class ThreadPool {
 public:
     explicit ThreadPool(size_t);
 
+    explicit ThreadPool(const ThreadPoolConfig &config);
+
     ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {}
 
     template<class F, class... Args>
     auto enqueue(F &&f, Args &&... args)
-    -> std::future<typename std::result_of<F(Args...)>::type>;
+    -> std::future<std::invoke_result_t<F, Args...>>;
+
+    // fire-and-forget submission: no future, no shared state, no allocation in steady state
+    template<class F>
+    void execute(F &&f);
+
+    size_t size() const { return workers.size(); }
+
+    // runs one pending task on the calling thread, if any can be found. Lets a thread that waits on
+    // pool work help execute it instead of blocking
+    bool try_run_pending();
 
     ~ThreadPool();
 
 private:
+    using TaskNode = thread_pool_detail::TaskNode;
+
+    struct alignas(thread_pool_detail::CACHE_LINE) Worker {
+        thread_pool_detail::WorkStealingDeque deque;
+    };
+
+    // identifies the pool (if any) the current thread works for
+    struct WorkerIdentity {
+        const ThreadPool *pool = nullptr;
+        size_t index = 0;
+        uint64_t rng = 0x9E3779B97F4A7C15ull;
+    };
+
+    static WorkerIdentity &identity() {
+        thread_local WorkerIdentity self;
+        return self;
+    }
+
+    void submit(TaskNode *node);
+
+    void worker_loop(size_t index, std::vector<int> cpus);
+
+    static void pin_current_thread(const std::vector<int> &cpus);
+
+    // index == queue_count means the caller has no deque of its own
+    TaskNode *find_task(size_t index);
+
+    bool has_visible_work() const;
+
+    static constexpr size_t INJECTION_CAPACITY = 1 << 14;
+    static constexpr int SPINS_BEFORE_PARKING = 64;
+
     // need to keep track of threads so we can join them
     std::vector<std::thread> workers;
-    // the task queue
-    std::queue<std::function<void()> > tasks;
+    // each worker allocates its own deque after pinning, so first-touch places it on the worker's node.
+    // That is the only node-local memory: task nodes and whatever the tasks allocate come from the
+    // ordinary heap, wherever the submitting or running thread happens to touch it first
+    std::vector<std::unique_ptr<Worker>> queues;
+    std::vector<int> worker_nodes;
+    size_t queue_count;
+    std::atomic<size_t> ready_workers{0};
+    // submissions from outside the pool
+    thread_pool_detail::InjectionQueue injection;
 
     // synchronization
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
+    thread_pool_detail::Parker parker;
+    std::atomic<bool> stop;
 };
 
 // the constructor just launches some amount of workers
 inline ThreadPool::ThreadPool(size_t threads)
-        : stop(false) {
-    for (size_t i = 0; i < threads; ++i)
-        workers.emplace_back(
-                [this] {
-                    for (;;) {
-                        std::function<void()> task;
-
-                        {
-                            std::unique_lock<std::mutex> lock(this->queue_mutex);
-                            this->condition.wait(lock,
-                                                 [this] { return this->stop || !this->tasks.empty(); });
-                            if (this->stop && this->tasks.empty())
-                                return;
-                            task = std::move(this->tasks.front());
-                            this->tasks.pop();
-                        }
-
-                        task();
-                    }
-                }
-        );
+        : ThreadPool(ThreadPoolConfig{threads, {}, {}}) {}
+
+inline ThreadPool::ThreadPool(const ThreadPoolConfig &config)
+        : queue_count(std::max<size_t>(1, config.threads == 0 ? std::thread::hardware_concurrency()
+                                                              : config.threads)),
+          injection(INJECTION_CAPACITY),
+          stop(false) {
+    queues.resize(queue_count);
+    worker_nodes.resize(queue_count, 0);
+    for (size_t i = 0; i < queue_count && i < config.worker_nodes.size(); ++i)
+        worker_nodes[i] = config.worker_nodes[i];
+    for (size_t i = 0; i < queue_count; ++i) {
+        std::vector<int> cpus = i < config.worker_cpus.size() ? config.worker_cpus[i] : std::vector<int>();
+        workers.emplace_back([this, i, cpus = std::move(cpus)]() mutable { worker_loop(i, std::move(cpus)); });
+    }
+    // nobody may submit or steal before every deque exists
+    while (ready_workers.load(std::memory_order_acquire) < queue_count)
+        std::this_thread::yield();
+}
+
+inline void ThreadPool::pin_current_thread(const std::vector<int> &cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    // best effort: a CPU outside the cgroup's allowance just leaves the worker unpinned
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpus;
+#endif
+}
+
+inline void ThreadPool::submit(TaskNode *node) {
+    WorkerIdentity &self = identity();
+    if (self.pool == this) {
+        queues[self.index]->deque.push(node);
+    } else {
+        // don't allow enqueueing after stopping the pool
+        if (stop.load(std::memory_order_acquire)) {
+            node->destroy(node);
+            thread_pool_detail::TaskNodeAllocator::release(node);
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        // injection queue is full: the submitter helps out, which also throttles it
+        while (!injection.push(node)) {
+            if (TaskNode *pending = injection.pop()) {
+                pending->run();
+                thread_pool_detail::TaskNodeAllocator::release(pending);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    parker.notify(false);
 }
 
 // add new work item to the pool
 template<class F, class... Args>
 auto ThreadPool::enqueue(F &&f, Args &&... args)
--> std::future<typename std::result_of<F(Args...)>::type> {
-    using return_type = typename std::result_of<F(Args...)>::type;
+-> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
+
+    std::promise<return_type> promise;
+    std::future<return_type> res = promise.get_future();
+    execute([promise = std::move(promise),
+             call = std::make_tuple(std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+        try {
+            if constexpr (std::is_void_v<return_type>) {
+                std::apply([](auto &&... xs) { std::invoke(std::move(xs)...); }, std::move(call));
+                promise.set_value();
+            } else {
+                promise.set_value(std::apply([](auto &&... xs) { return std::invoke(std::move(xs)...); },
+                                             std::move(call)));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    });
+    return res;
+}
 
-    auto task = std::make_shared<std::packaged_task<return_type()> >(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-    );
+template<class F>
+void ThreadPool::execute(F &&f) {
+    TaskNode *node = thread_pool_detail::TaskNodeAllocator::allocate();
+    try {
+        node->emplace(std::forward<F>(f));
+    } catch (...) {
+        // the callable could not be moved in, the node goes back unused
+        thread_pool_detail::TaskNodeAllocator::release(node);
+        throw;
+    }
+    submit(node);
+}
 
-    std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+inline ThreadPool::TaskNode *ThreadPool::find_task(size_t index) {
+    if (index < queue_count) {
+        if (TaskNode *node = queues[index]->deque.pop()) return node;
+    }
+    if (TaskNode *node = injection.pop()) return node;
+    // pick a random victim and sweep every other worker once
+    WorkerIdentity &self = identity();
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+    // first pass stays on the thief's NUMA node, second pass crosses nodes
+    size_t start = static_cast<size_t>(self.rng % queue_count);
+    int home = index < queue_count ? worker_nodes[index] : -1;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < queue_count; ++i) {
+            size_t victim = (start + i) % queue_count;
+            if (victim == index) continue;
+            if (home >= 0 && (worker_nodes[victim] == home) != (pass == 0)) continue;
+            if (TaskNode *node = queues[victim]->deque.steal()) return node;
+        }
+        if (home < 0) break;
+    }
+    return nullptr;
+}
 
-        // don't allow enqueueing after stopping the pool
-        if (stop)
-            throw std::runtime_error("enqueue on stopped ThreadPool");
+inline bool ThreadPool::try_run_pending() {
+    WorkerIdentity &self = identity();
+    TaskNode *node = find_task(self.pool == this ? self.index : queue_count);
+    if (node == nullptr) return false;
+    node->run();
+    thread_pool_detail::TaskNodeAllocator::release(node);
+    return true;
+}
 
-        tasks.emplace([task]() { (*task)(); });
+inline bool ThreadPool::has_visible_work() const {
+    if (!injection.empty()) return true;
+    for (size_t i = 0; i < queue_count; ++i) {
+        if (!queues[i]->deque.empty()) return true;
+    }
+    return false;
+}
+
+inline void ThreadPool::worker_loop(size_t index, std::vector<int> cpus) {
+    pin_current_thread(cpus);
+    queues[index] = std::make_unique<Worker>();
+    ready_workers.fetch_add(1, std::memory_order_release);
+    while (ready_workers.load(std::memory_order_acquire) < queue_count)
+        std::this_thread::yield();
+
+    WorkerIdentity &self = identity();
+    self.pool = this;
+    self.index = index;
+    self.rng += index * 0x2545F4914F6CDD1Dull;
+
+    int idle_spins = 0;
+    for (;;) {
+        if (TaskNode *node = find_task(index)) {
+            node->run();
+            thread_pool_detail::TaskNodeAllocator::release(node);
+            idle_spins = 0;
+            continue;
+        }
+        if (++idle_spins < SPINS_BEFORE_PARKING) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t ticket = parker.prepare_wait();
+        if (has_visible_work()) {
+            parker.cancel_wait();
+            continue;
+        }
+        if (stop.load(std::memory_order_acquire)) {
+            parker.cancel_wait();
+            return;
+        }
+        parker.commit_wait(ticket);
+        idle_spins = 0;
     }
-    condition.notify_one();
-    return res;
 }
 
 // the destructor joins all threads
 inline ThreadPool::~ThreadPool() {
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        stop = true;
-    }
-    condition.notify_all();
+    stop.store(true, std::memory_order_seq_cst);
+    parker.notify(true);
     for (std::thread &worker: workers)
         worker.join();
 }